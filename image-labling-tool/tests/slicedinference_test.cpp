@@ -0,0 +1,85 @@
+#include "stubdetector.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const char *what)
+{
+    if (!condition) {
+        std::fprintf(stderr, "FAILED: %s\n", what);
+        failures++;
+    }
+}
+
+// box nằm trong vùng chồng lấn xuất hiện ở 2 tile và lượt toàn ảnh -> gộp còn 1
+void testDetectMergesOverlap()
+{
+    cv::Mat img(1200, 1600, CV_8UC3, cv::Scalar::all(0));
+    StubDetector detector({{0, 0.9f, cv::Rect2f(560, 100, 40, 40)},
+                           {1, 0.8f, cv::Rect2f(1400, 1000, 60, 60)},
+                           {1, 0.1f, cv::Rect2f(300, 300, 50, 50)}});
+    detector.setMinVisible(1.0);
+
+    SlicedInference::Options options;
+    options.batchSize = 4;
+    SlicedInference inference(options);
+
+    QVector<cv::Rect> rois = SlicedInference::sliceGrid(img.cols, img.rows, options.tileSize, options.overlap);
+    check(rois.size() > 1, "large image is sliced");
+    check(rois.back().br() == cv::Point(img.cols, img.rows), "last tile reaches the image corner");
+
+    QVector<Detection> found = inference.detect(img, detector, 0.25);
+    check(found.size() == 2, "duplicates merged and low scores dropped");
+    check(detector.tiles() == rois.size() + 1, "every tile plus the full image pass reach the detector");
+    check(detector.batches() == (detector.tiles() + options.batchSize - 1) / options.batchSize, "tiles are batched");
+    for (const Detection &d : found) {
+        if (d.cls == 0)
+            check(std::abs(d.box.x - 560.0f) < 1.0f && std::abs(d.box.width - 40.0f) < 1.0f, "box mapped back to image space");
+    }
+}
+
+// label được ghi vào đường dẫn đã ghép, không phải cạnh ảnh
+void testLabelImagesUsesPairedLabel()
+{
+    QTemporaryDir dir;
+    QDir root(dir.path());
+    root.mkpath("images");
+    root.mkpath("labels");
+    QString imagePath = root.filePath("images/a.png");
+    QString labelPath = root.filePath("labels/a.txt");
+    cv::imwrite(imagePath.toStdString(), cv::Mat(1000, 1000, CV_8UC3, cv::Scalar::all(0)));
+
+    StubDetector detector({{2, 0.9f, cv::Rect2f(450, 450, 100, 100)}});
+    QHash<QString, QString> labelPaths {{imagePath, labelPath}};
+    ProgressChannel progress;
+    progress.start(1, SlicedInference::progressStages());
+
+    int labelled = SlicedInference().labelImages({imagePath}, detector, 0.25, &progress, &labelPaths);
+    check(labelled == 1, "image labelled");
+    check(!QFile::exists(root.filePath("images/a.txt")), "no label written next to the image");
+
+    bool ok = false;
+    QVector<BBox> boxes = YoloLabel::read(labelPath, &ok);
+    check(ok && boxes.size() == 1, "paired label holds the merged box");
+    if (!boxes.isEmpty()) {
+        check(boxes[0].cls == 2, "class kept");
+        check(std::abs(boxes[0].xc - 0.5f) < 0.01f && std::abs(boxes[0].w - 0.1f) < 0.01f, "box normalized to the image");
+    }
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    testDetectMergesOverlap();
+    testLabelImagesUsesPairedLabel();
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,26 @@
+#include "stubdetector.h"
+
+QVector<QVector<Detection>> StubDetector::detectBatch(const std::vector<cv::Mat> &images, double minimumScore)
+{
+    m_batches++;
+    QVector<QVector<Detection>> results;
+    for (const cv::Mat &tile : images) {
+        m_tiles++;
+        cv::Size whole;
+        cv::Point origin;
+        tile.locateROI(whole, origin);
+        cv::Rect2f roi(float(origin.x), float(origin.y), float(tile.cols), float(tile.rows));
+
+        QVector<Detection> found;
+        for (const Detection &d : m_detections) {
+            if (d.score < minimumScore) continue;
+            cv::Rect2f visible = d.box & roi;
+            if (visible.area() <= 0.0f || visible.area() < m_minVisible * d.box.area()) continue;
+            Detection out = d;
+            out.box = cv::Rect2f(visible.x - roi.x, visible.y - roi.y, visible.width, visible.height);
+            found.push_back(out);
+        }
+        results.push_back(found);
+    }
+    return results;
+}
@@ -0,0 +1,30 @@
+#ifndef STUBDETECTOR_H
+#define STUBDETECTOR_H
+
+#include "ui/dialog/augment/slicedinference.h"
+
+// Detector giả (không cần model): trả về các box cho trước theo toạ độ ảnh gốc, cắt theo tile.
+// Gốc của tile lấy từ locateROI nên cắt lát, dời toạ độ và gộp NMS/WBF kiểm tra được đầu-cuối
+class StubDetector : public Detector
+{
+public:
+    StubDetector() = default;
+    explicit StubDetector(const QVector<Detection> &detections) : m_detections(detections) { }
+
+    void setDetections(const QVector<Detection> &detections) { m_detections = detections; }
+    // box bị tile cắt chỉ được trả về khi phần còn thấy >= tỉ lệ này (như model thật bỏ object bị cắt quá nhiều)
+    void setMinVisible(double fraction) { m_minVisible = fraction; }
+
+    int batches() const { return m_batches; }
+    int tiles() const { return m_tiles; }
+
+    QVector<QVector<Detection>> detectBatch(const std::vector<cv::Mat> &images, double minimumScore) override;
+
+private:
+    QVector<Detection> m_detections;
+    double m_minVisible {0.5};
+    int m_batches {0};
+    int m_tiles {0};
+};
+
+#endif // STUBDETECTOR_H
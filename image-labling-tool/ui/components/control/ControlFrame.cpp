@@ -2,6 +2,9 @@
 #include "common/log/Logger.h"
 #include "ui/dialog/autolabeling/AutoLabelingDialog.h"
 #include "ui/dialog/augment/augmentdialog.h"
+#include "ui/dialog/augment/datasetscanner.h"
+#include "ui/dialog/augment/dnndetector.h"
+#include <QtConcurrent/QtConcurrent>
 #include <qdialog.h>
 #include <qnamespace.h>
 #include <qtdeprecationdefinitions.h>
@@ -21,10 +24,19 @@ ControlFrame::ControlFrame(QWidget *parent, DataManager *dataSrc)
     _interactionModeGroup->addButton(_ui->drawModeRadioButton, static_cast<int>(InteractionMode::DrawMode));
     _interactionModeGroup->addButton(_ui->editModeRadioButton, static_cast<int>(InteractionMode::EditMode));
 
+    _autoLabelingMonitor = new ProgressMonitor(&_autoLabelingProgress, this);
+    connect(_autoLabelingMonitor, &ProgressMonitor::advanced, this, &ControlFrame::updateAutolabelingProgress);
+    connect(&_slicedAutoLabelingWatcher, &QFutureWatcher<int>::finished, this, [=]() {
+        int labelled = _slicedAutoLabelingWatcher.result();
+        emit closeAutoLabelingDialog();
+        emit slicedAutoLabelingFinished(labelled);
+    });
+
     setupConnections();
 }
 
 ControlFrame::~ControlFrame() {
+    _slicedAutoLabelingWatcher.waitForFinished();
     delete _ui;
 }
 
@@ -178,11 +190,22 @@ void ControlFrame::showAutoLabelingDialog() {
         if(result == QDialog::Accepted) {
             Logger::logInfo(Q_FUNC_INFO, QString("auto labeling with model: %1 and minium score: %2").arg(dialog->modelPath()).arg(dialog->miniumScore()));
             connect(this, &ControlFrame::updateAutolabelingProgress, dialog, &AutoLabelingDialog::updateProgress, Qt::UniqueConnection);
+            if (isSlicedAutoLabeling()) {
+                _autoLabelingProgress.start(0, SlicedInference::progressStages());
+                _autoLabelingMonitor->start();
+                runSlicedAutoLabeling(dialog->modelPath(), dialog->miniumScore());
+                return;
+            }
+            _autoLabelingProgress.start(_autoLabelingTotalImages);
+            _autoLabelingMonitor->start();
             emit autoLabeling(dialog->modelPath(), dialog->miniumScore());
         }
     }, Qt::SingleShotConnection);
 
     connect(this, &ControlFrame::closeAutoLabelingDialog, dialog, [=]() {
+        _autoLabelingProgress.finish();
+        _autoLabelingMonitor->stop();
+        Logger::logInfo(Q_FUNC_INFO, QString("auto labeling: %1").arg(_autoLabelingMonitor->last().text()));
         dialog->close();
     }, Qt::SingleShotConnection);
 
@@ -194,13 +217,59 @@ void ControlFrame::setAutoLabelingTotalImages(int count) {
 }
 
 void ControlFrame::emitUpdateAutolabelingProgress(int increment) {
-    emit updateAutolabelingProgress(increment);
+    _autoLabelingProgress.itemsDone(increment);
 }
 
 void ControlFrame::emitCloseAutoLabelingDialog() {
     emit closeAutoLabelingDialog();
 }
 
+void ControlFrame::runSlicedAutoLabeling(const QString &modelPath, double miniumScore) {
+    SlicedInference::Options options = slicedInferenceOptions();
+    QString folder = _dataSrc ? _dataSrc->sourceDir() : QString();
+
+    _slicedAutoLabelingWatcher.setFuture(QtConcurrent::run([this, modelPath, miniumScore, options, folder]() {
+        // images paired with their labels the same way the augment dialog pairs them (labels/ tree or next to the image)
+        QStringList imagePaths;
+        QHash<QString, QString> labelPaths;
+        DatasetScanner scanner;
+        scanner.scan(folder, [&](const QVector<DatasetScanner::Entry> &batch) {
+            for (const auto &entry : batch) {
+                imagePaths << entry.imagePath;
+                if (!entry.labelPath.isEmpty())
+                    labelPaths.insert(entry.imagePath, entry.labelPath);
+            }
+            return true;
+        });
+        imagePaths.sort();
+        _autoLabelingProgress.addTotal(imagePaths.size());
+
+        DnnDetector detector(modelPath, options.tileSize);
+        if (!detector.isLoaded()) {
+            qWarning() << "Sliced auto labeling: cannot load model" << modelPath << detector.error();
+            return 0;
+        }
+        return SlicedInference(options).labelImages(imagePaths, detector, miniumScore, &_autoLabelingProgress, &labelPaths);
+    }));
+}
+
+bool ControlFrame::isSlicedAutoLabeling() {
+    return _ui->slicedAutoLabelingCheckBox->isChecked();
+}
+
+SlicedInference::Options ControlFrame::slicedInferenceOptions() {
+    SlicedInference::Options options;
+    QStringList parts = _ui->slicedTileSizeComboBox->currentText().split('x');
+    if (parts.size() == 2) {
+        options.tileSize = QSize(parts[0].trimmed().toInt(), parts[1].trimmed().toInt());
+    }
+    return options;
+}
+
+ProgressChannel *ControlFrame::autoLabelingProgress() {
+    return &_autoLabelingProgress;
+}
+
 bool ControlFrame::isShowCategoryLabel() {
     return _ui->showCategoryLabelCheckBox->isChecked();
 }
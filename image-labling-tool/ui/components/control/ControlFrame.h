@@ -6,9 +6,12 @@
 #include "ui/forms/forms.h"
 #include <QFrame>
 #include <QButtonGroup>
+#include <QFutureWatcher>
 #include <functional>
 #include <qwidget.h>
 #include "ui/enum/InteractionMode.h"
+#include "ui/dialog/augment/slicedinference.h"
+#include "ui/dialog/augment/progresschannel.h"
 
 class DataManager;
 
@@ -41,9 +44,16 @@ public:
     };
 
     void setAutoLabelingTotalImages(int count);
+    // only bumps a counter; the dialog is updated by a sampling timer, safe from worker threads
     void emitUpdateAutolabelingProgress(int increment);
     void emitCloseAutoLabelingDialog();
 
+    // sliced auto labeling options; when checked the model runs here on tiles instead of autoLabeling()
+    bool isSlicedAutoLabeling();
+    SlicedInference::Options slicedInferenceOptions();
+    // counters of the running auto labeling, for handlers that report per stage
+    ProgressChannel *autoLabelingProgress();
+
     bool isShowCategoryLabel();
     double labelBorderWidth();
     double categoryLabelTextSize();
@@ -58,16 +68,22 @@ signals:
     void autoLabeling(QString modelPath, double miniumScore);
     void updateAutolabelingProgress(int increment);
     void closeAutoLabelingDialog();
+    // sliced auto labeling wrote the labels to disk, the owner reloads them
+    void slicedAutoLabelingFinished(int labelledImages);
 
 protected:
     virtual QHash<QString, PropertyUpdateHandler<ControlFrame>::UpdateHandler> initSetterMap();
     void setupConnections();
+    void runSlicedAutoLabeling(const QString &modelPath, double miniumScore);
 
     Ui::ControlFrame *_ui;
     QButtonGroup *_interactionModeGroup;
     PropertyUpdateHandler<ControlFrame> _propertyUpdateHandler;
 
     int _autoLabelingTotalImages; // use for auto labeling dialog
+    ProgressChannel _autoLabelingProgress;
+    ProgressMonitor *_autoLabelingMonitor;
+    QFutureWatcher<int> _slicedAutoLabelingWatcher;
 private:
     DataManager *_dataSrc = nullptr;
 };
@@ -3,11 +3,17 @@
 #include <QFileDialog>
 #include <QStandardPaths>
 #include "imagetiler.h"
+#include "augmentrunner.h"
+#include "augmentplanner.h"
+#include "datasetexporter.h"
+#include "shardcoordinator.h"
 #include <QRegularExpression>
+#include <QtConcurrent/QtConcurrent>
 
 #include <QFile>
-#include <QTextStream>
 #include <QImage>
+#include <QImageReader>
+#include <QThread>
 #include <QDebug>
 #include <algorithm>
 #include <QMessageBox>
@@ -21,8 +27,22 @@ AugmentDialog::AugmentDialog(QWidget *parent, DataSource *dataSrc)
     ui->imageTableWidget->setEditTriggers(QAbstractItemView::NoEditTriggers);
 
     this->setFixedSize(this->size());
+    connect(&_scanWatcher, &QFutureWatcher<int>::finished,
+            this, &AugmentDialog::scanFinished);
     loadImageList(_dataSrc->sourceDir());
     ui->tileDimensionWidget->setVisible(false);
+    ui->tileGateWidget->setVisible(false);
+    ui->policyWidget->setVisible(false);
+    ui->encoderProfileComboBox->addItems(EncoderProfile::names());
+    ui->generateProgressBar->setVisible(false);
+    ui->progressLabel->setVisible(false);
+
+    // worker chỉ cộng counter, GUI lấy mẫu 10 lần/giây
+    _progressMonitor = new ProgressMonitor(&_progress, this);
+    connect(_progressMonitor, &ProgressMonitor::progressed,
+            this, &AugmentDialog::updateProgress);
+    connect(&_generateWatcher, &QFutureWatcher<void>::finished,
+            this, &AugmentDialog::generationFinished);
 
     connect(ui->imageTableWidget->selectionModel(), &QItemSelectionModel::selectionChanged,
             this, &AugmentDialog::updateSelectionCount);
@@ -30,23 +50,59 @@ AugmentDialog::AugmentDialog(QWidget *parent, DataSource *dataSrc)
     connect(ui->openFileButton, &QPushButton::clicked,
             this, &AugmentDialog::openFileDialog);
 
+    connect(ui->scanDepthSpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
+            this, [=]() { loadImageList(ui->imageFolderPathLineEdit->text()); });
+
     connect(ui->augmentationMethodComboBox, &QComboBox::currentTextChanged,
             this, [=](const QString &text) {
                 ui->tileDimensionWidget->setVisible(text.contains("Tile"));
+                ui->tileGateWidget->setVisible(text.contains("Tile"));
+                ui->policyWidget->setVisible(text.contains("Policy"));
             });
 
-    connect(ui->fileNameFilterLineEdit, &QLineEdit::textChanged,
+    _filterTimer.setSingleShot(true);
+    _filterTimer.setInterval(300);
+    connect(&_filterTimer, &QTimer::timeout,
             this, &AugmentDialog::applyFilter);
 
+    connect(ui->fileNameFilterLineEdit, &QLineEdit::textChanged,
+            &_filterTimer, QOverload<>::of(&QTimer::start));
+
     connect(ui->classFilterComboBox, &QComboBox::currentTextChanged,
             this, &AugmentDialog::applyFilter);
 
     connect(ui->augmentedOnlyCheckBox, &QCheckBox::toggled,
             this, &AugmentDialog::applyFilter);
+
+    connect(ui->boxQueryLineEdit, &QLineEdit::textChanged,
+            &_filterTimer, QOverload<>::of(&QTimer::start));
+
+    connect(ui->boxQueryLineEdit, &QLineEdit::returnPressed,
+            this, [=]() {
+                _filterTimer.stop();
+                applyFilter();
+            });
+
+    connect(ui->duplicateRadiusSpinBox, QOverload<int>::of(&QSpinBox::valueChanged),
+            this, [=]() {
+                updateDuplicates();
+                applyFilter();
+            });
+
+    connect(ui->hideDuplicatesCheckBox, &QCheckBox::toggled,
+            this, &AugmentDialog::applyFilter);
+
+    connect(ui->boxQueryLineEdit, &QLineEdit::returnPressed,
+            ui->imageTableWidget, &QTableWidget::selectAll);
 }
 
 AugmentDialog::~AugmentDialog()
 {
+    _generateWatcher.waitForFinished(); // worker còn dùng _progress
+    ++_scanGeneration;                  // scanner dừng ở batch kế tiếp
+    _scanWatcher.waitForFinished();
+    for (auto &scan : _staleScans)
+        scan.waitForFinished();
     delete ui;
 }
 
@@ -74,54 +130,231 @@ void AugmentDialog::loadImageList(const QString &folder)
 
     ui->imageFolderPathLineEdit->setText(folder);
 
-    QDir dir(folder);
-    QStringList filters = {"*.jpg", "*.jpeg", "*.png", "*.bmp"};
-    _allFiles = dir.entryInfoList(filters, QDir::Files);   //  lưu danh sách file gốc
+    // worker đang chạy có thể còn đọc _index/_labelPaths -> quét lại sau khi chạy xong
+    if (_generateWatcher.isRunning()) {
+        _pendingScanFolder = folder;
+        return;
+    }
+
+    // lần quét trước (nếu còn) thấy generation đổi sẽ dừng ở chunk kế tiếp; không đợi trên GUI thread
+    int generation = ++_scanGeneration;
+    _staleScans.erase(std::remove_if(_staleScans.begin(), _staleScans.end(),
+                                     [](const QFuture<int> &f) { return f.isFinished(); }),
+                      _staleScans.end());
+    if (_scanWatcher.isRunning())
+        _staleScans << _scanWatcher.future();
+
+    _allFiles.clear();   //  danh sách file gốc, được điền dần theo từng batch
+    _labelPaths.clear();
+    _duplicateOf.clear();
+    _duplicateCount.clear();
+    _scanFolder = folder;
+    applyFilter();       // bảng rỗng, hàng được thêm khi scanner trả về
+
+    DatasetScanner scanner;
+    scanner.setMaxDepth(ui->scanDepthSpinBox->value());
+    _scanWatcher.setFuture(QtConcurrent::run([this, scanner, folder, generation]() mutable {
+        scanner.scan(folder, [this, generation](const QVector<DatasetScanner::Entry> &batch) {
+            if (_scanGeneration != generation) return false;
+            QMetaObject::invokeMethod(this, [this, generation, batch]() {
+                appendScanned(generation, batch);
+            }, Qt::QueuedConnection);
+            return true;
+        });
+        return generation;
+    }));
+}
+
+void AugmentDialog::appendScanned(int generation, const QVector<DatasetScanner::Entry> &batch)
+{
+    if (generation != _scanGeneration) return;
+
+    // lọc theo class/box cần index -> đợi quét xong mới hiện hàng
+    bool showRows = !filterNeedsIndex();
+    for (const auto &entry : batch) {
+        QFileInfo imgFile(entry.imagePath);
+        _allFiles << imgFile;
+        if (!entry.labelPath.isEmpty())
+            _labelPaths.insert(entry.imagePath, entry.labelPath);
+
+        if (showRows && matchesNameFilter(imgFile)) {
+            int row = ui->imageTableWidget->rowCount();
+            ui->imageTableWidget->insertRow(row);
+            addRowFromFile(imgFile, row);
+        }
+    }
+    ui->countLabel->setText(QString("%1 images (scanning %2...)")
+                                .arg(ui->imageTableWidget->rowCount())
+                                .arg(_allFiles.size()));
+}
+
+void AugmentDialog::scanFinished()
+{
+    // lần quét đã bị thay bởi lần khác (bảng đang điền dần cho thư mục mới)
+    if (_scanWatcher.future().isCanceled() || _scanWatcher.result() != _scanGeneration)
+        return;
+
+    // batch của các thư mục đọc song song tới xen kẽ -> sắp lại để index / nhóm trùng không phụ thuộc thread
+    std::sort(_allFiles.begin(), _allFiles.end(), [](const QFileInfo &a, const QFileInfo &b) {
+        return a.absoluteFilePath() < b.absoluteFilePath();
+    });
+
+    QStringList imagePaths;
+    for (const QFileInfo &imgFile : _allFiles)
+        imagePaths << imgFile.absoluteFilePath();
+
+    // cùng thư mục -> chỉ cập nhật các label đã đổi
+    if (_scanFolder == _indexedFolder) {
+        _index.refresh(imagePaths, &_labelPaths);
+    } else {
+        _index.build(imagePaths, &_labelPaths);
+        _indexedFolder = _scanFolder;
+    }
+    updateClassFilter();
+    _boxIndexDirty = true;   // box index dựng lại khi có query
+    updateDuplicates();
+
+    if (filterNeedsIndex() || !_duplicateOf.isEmpty()) {
+        applyFilter(); // hiển thị theo filter hiện tại, ảnh đầu nhóm trùng có thêm số bản trùng
+    } else {
+        for (int row = 0; row < ui->imageTableWidget->rowCount(); ++row)
+            updateBoxColumns(row); // hàng thêm lúc đang quét chưa có kích thước box
+        ui->countLabel->setText(QString("%1 images").arg(ui->imageTableWidget->rowCount()));
+    }
+}
+
+bool AugmentDialog::filterNeedsIndex() const
+{
+    // index 0 là All Images; Labelled/Unlabelled/class đều đọc từ DatasetIndex
+    return ui->classFilterComboBox->currentIndex() > 0 || !ui->boxQueryLineEdit->text().trimmed().isEmpty()
+           || ui->hideDuplicatesCheckBox->isChecked();
+}
+
+bool AugmentDialog::matchesNameFilter(const QFileInfo &imgFile) const
+{
+    // --- lọc theo tên ---
+    QString nameFilter = ui->fileNameFilterLineEdit->text().trimmed();
+    if (!nameFilter.isEmpty() && !imgFile.fileName().contains(nameFilter, Qt::CaseInsensitive))
+        return false;
+
+    // --- lọc Augmented Only ---
+    if (ui->augmentedOnlyCheckBox->isChecked()) {
+        static const QRegularExpression rx("(_FH|_FV|_R90|_R-90|_A\\d+|\\[(\\d+|L\\d+_x\\d+_y\\d+)\\])$");
+        if (rx.match(imgFile.completeBaseName()).hasMatch()) return false;
+    }
+    return true;
+}
+
+void AugmentDialog::updateClassFilter()
+{
+    QVariant currentClass = ui->classFilterComboBox->currentData();
+    QString currentText = ui->classFilterComboBox->currentText();
+
+    QSignalBlocker blocker(ui->classFilterComboBox);
+    while (ui->classFilterComboBox->count() > 3)   // giữ All Images / Labelled / Unlabelled
+        ui->classFilterComboBox->removeItem(3);
+
+    for (int cls : _index.classIds()) {
+        ui->classFilterComboBox->addItem(QString("Class %1 (%2 images, %3 boxes)")
+                                             .arg(cls)
+                                             .arg(_index.imageCount(cls))
+                                             .arg(_index.boxCount(cls)),
+                                         cls);
+    }
 
-    applyFilter(); // hiển thị theo filter hiện tại
+    int idx = currentClass.isValid() ? ui->classFilterComboBox->findData(currentClass)
+                                     : ui->classFilterComboBox->findText(currentText);
+    ui->classFilterComboBox->setCurrentIndex(std::max(0, idx));
 }
 
 void AugmentDialog::applyFilter()
 {
+    _filterTimer.stop();
     ui->imageTableWidget->setRowCount(0);
 
-    QString nameFilter   = ui->fileNameFilterLineEdit->text().trimmed();
+    // đang quét: index còn là của lần quét trước -> chỉ lọc theo tên, không dựng / lưu box index từ dữ liệu dở dang;
+    // scanFinished() lọc lại đầy đủ
+    if (_scanWatcher.isRunning()) {
+        if (!filterNeedsIndex()) {
+            for (const QFileInfo &imgFile : _allFiles) {
+                if (!matchesNameFilter(imgFile)) continue;
+                int row = ui->imageTableWidget->rowCount();
+                ui->imageTableWidget->insertRow(row);
+                addRowFromFile(imgFile, row);
+            }
+        }
+        ui->countLabel->setText(QString("%1 images (scanning %2...)")
+                                    .arg(ui->imageTableWidget->rowCount())
+                                    .arg(_allFiles.size()));
+        return;
+    }
+
     QString classFilter  = ui->classFilterComboBox->currentText();
-    bool showAugmented   = ui->augmentedOnlyCheckBox->isChecked();
+    QVariant classId     = ui->classFilterComboBox->currentData();
+
+    // --- box query: quét cột trên box index thay vì đọc lại từng file label ---
+    QString queryText = ui->boxQueryLineEdit->text().trimmed();
+    BoxQuery query;
+    QString queryError;
+    bool useQuery = !queryText.isEmpty() && BoxQuery::parse(queryText, &query, &queryError);
+    ui->boxQueryLineEdit->setStyleSheet(queryError.isEmpty() ? QString() : "color: red");
+
+    QVector<bool> queryMatch;
+    if (useQuery) {
+        if (_boxIndexDirty) {
+            QStringList imagePaths;
+            for (const QFileInfo &imgFile : _allFiles)
+                imagePaths << imgFile.absoluteFilePath();
+
+            // file cạnh ảnh còn khớp chữ ký -> chỉ mmap; không thì gom lại từ DatasetIndex (không đọc đĩa) rồi lưu
+            QString path = BoxIndex::defaultPath(_scanFolder);
+            quint64 signature = BoxIndex::signature(_index, imagePaths);
+            if (!QFile::exists(path) || !_boxIndex.open(path) || _boxIndex.signature() != signature) {
+                _boxIndex.build(_index, imagePaths);
+                _boxIndex.save(path);
+            }
+            _boxIndexDirty = false;
+        }
+        queryMatch.fill(false, _boxIndex.imageCount());
+        for (int id : _boxIndex.select(query))
+            queryMatch[id] = true;
+    }
 
     for (const QFileInfo &imgFile : _allFiles) {
-        QString baseName = imgFile.completeBaseName();
-        QString labelPath = imgFile.absolutePath() + "/" + baseName + ".txt";
-
-        // --- lọc theo tên ---
-        if (!nameFilter.isEmpty() && !imgFile.fileName().contains(nameFilter, Qt::CaseInsensitive))
+        // --- lọc theo tên / Augmented Only ---
+        if (!matchesNameFilter(imgFile))
             continue;
 
-        // --- lọc theo Labeled/Unlabeled ---
-        bool hasLabel = false;
-        if (QFile::exists(labelPath)) {
-            QFile labelFile(labelPath);
-            if (labelFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-                hasLabel = !labelFile.readAll().trimmed().isEmpty(); // true nếu file có nội dung
-            }
-        }
+        // --- lọc theo Labeled/Unlabeled / class (dùng index, không đọc lại file label) ---
+        bool hasLabel = _index.hasLabel(imgFile.absoluteFilePath());
 
         if (classFilter == "Labelled" && !hasLabel) continue;
         if (classFilter == "Unlabelled" && hasLabel) continue;
+        if (classId.isValid()) {
+            int id = _index.imageId(imgFile.absoluteFilePath());
+            if (id < 0 || !_index.image(id).classCounts.contains(classId.toInt())) continue;
+        }
 
-        // --- lọc Augmented Only ---
-        if (showAugmented) {
-            QRegularExpression rx("(_FH|_FV|_R90|_R-90|\\[\\d+\\])$");
-            if (rx.match(baseName).hasMatch()) continue;
+        if (useQuery) {
+            int id = _boxIndex.imageId(imgFile.absoluteFilePath());
+            if (id < 0 || !queryMatch[id]) continue;
         }
 
+        // --- gộp ảnh gần trùng: chỉ hiện ảnh đầu nhóm ---
+        if (ui->hideDuplicatesCheckBox->isChecked() && _duplicateOf.contains(imgFile.absoluteFilePath()))
+            continue;
+
         // thêm row
         int row = ui->imageTableWidget->rowCount();
         ui->imageTableWidget->insertRow(row);
         addRowFromFile(imgFile, row);
     }
 
-    ui->countLabel->setText(QString("%1 images").arg(ui->imageTableWidget->rowCount()));
+    ui->countLabel->setText(_duplicateOf.isEmpty()
+                                ? QString("%1 images").arg(ui->imageTableWidget->rowCount())
+                                : QString("%1 images, %2 near-duplicates")
+                                      .arg(ui->imageTableWidget->rowCount())
+                                      .arg(_duplicateOf.size()));
 
     ui->imageTableWidget->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);           // Image chiếm hết khoảng trống
     ui->imageTableWidget->horizontalHeader()->setSectionResizeMode(1, QHeaderView::ResizeToContents); // Largest Object
@@ -132,62 +365,48 @@ void AugmentDialog::applyFilter()
 
 void AugmentDialog::addRowFromFile(const QFileInfo &imgFile, int row)
 {
-    QString largestInfo = "0 x 0";
-    QString smallestInfo = "0 x 0";
-
-    QImage img(imgFile.absoluteFilePath());
-    QString labelPath = imgFile.absolutePath() + "/" + imgFile.completeBaseName() + ".txt";
-
-    if (!img.isNull() && QFile::exists(labelPath)) {
-        int imgW = img.width();
-        int imgH = img.height();
-
-        QFile labelFile(labelPath);
-        if (labelFile.open(QIODevice::ReadOnly)) {
-            QTextStream in(&labelFile);
-            QList<BBox> boxes;
-
-            while (!in.atEnd()) {
-                BBox b;
-                QString line = in.readLine().trimmed();
-                if (line.isEmpty()) continue;
+    int similar = _duplicateCount.value(imgFile.absoluteFilePath());
+    QTableWidgetItem *item0 = new QTableWidgetItem(
+        similar > 0 ? QString("%1 (+%2 similar)").arg(imgFile.fileName()).arg(similar) : imgFile.fileName());
+    item0->setData(Qt::UserRole, imgFile.absoluteFilePath());
+    item0->setFlags(item0->flags() & ~Qt::ItemIsEditable);
+    ui->imageTableWidget->setItem(row, 0, item0);
 
-                QTextStream ls(&line, QIODevice::ReadOnly);
-                ls >> b.cls >> b.xc >> b.yc >> b.w >> b.h;
-                if (ls.status() != QTextStream::Ok) continue;
+    updateBoxColumns(row);
+}
 
-                if (b.w > 0 && b.h > 0 && b.w <= 1 && b.h <= 1) {
-                    boxes.append(b);
-                }
+void AugmentDialog::updateBoxColumns(int row)
+{
+    QTableWidgetItem *item = ui->imageTableWidget->item(row, 0);
+    if (!item) return;
+
+    // kích thước ảnh + box lấy từ DatasetIndex (đã đọc khi dựng index), không đọc file trên GUI thread;
+    // đang quét thì index chưa có ảnh mới -> để trống, scanFinished() điền lại
+    QString largestInfo;
+    QString smallestInfo;
+    if (!_scanWatcher.isRunning()) {
+        largestInfo = smallestInfo = "0 x 0";
+        int id = _index.imageId(item->data(Qt::UserRole).toString());
+        if (id >= 0 && _index.image(id).imageSize.isValid()) {
+            const DatasetIndex::ImageEntry &entry = _index.image(id);
+            int imgW = entry.imageSize.width();
+            int imgH = entry.imageSize.height();
+
+            const BBox *largest = nullptr;
+            const BBox *smallest = nullptr;
+            for (const BBox &b : entry.boxes) {
+                if (b.w <= 0 || b.h <= 0 || b.w > 1 || b.h > 1) continue;
+                if (!largest || b.w * b.h > largest->w * largest->h) largest = &b;
+                if (!smallest || b.w * b.h < smallest->w * smallest->h) smallest = &b;
             }
 
-            if (!boxes.isEmpty()) {
-                auto largest = std::max_element(boxes.begin(), boxes.end(),
-                                                [imgW, imgH](const BBox &a, const BBox &b) {
-                                                    return (a.w * imgW) * (a.h * imgH) < (b.w * imgW) * (b.h * imgH);
-                                                });
-                auto smallest = std::min_element(boxes.begin(), boxes.end(),
-                                                 [imgW, imgH](const BBox &a, const BBox &b) {
-                                                     return (a.w * imgW) * (a.h * imgH) < (b.w * imgW) * (b.h * imgH);
-                                                 });
-
-                int lw = int(largest->w * imgW);
-                int lh = int(largest->h * imgH);
-                int sw = int(smallest->w * imgW);
-                int sh = int(smallest->h * imgH);
-
-                largestInfo = QString("%1 x %2").arg(lw).arg(lh);
-                smallestInfo = QString("%1 x %2").arg(sw).arg(sh);
+            if (largest) {
+                largestInfo = QString("%1 x %2").arg(int(largest->w * imgW)).arg(int(largest->h * imgH));
+                smallestInfo = QString("%1 x %2").arg(int(smallest->w * imgW)).arg(int(smallest->h * imgH));
             }
         }
     }
 
-    // Thêm row vào bảng
-    QTableWidgetItem *item0 = new QTableWidgetItem(imgFile.fileName());
-    item0->setData(Qt::UserRole, imgFile.absoluteFilePath());
-    item0->setFlags(item0->flags() & ~Qt::ItemIsEditable);
-    ui->imageTableWidget->setItem(row, 0, item0);
-
     ui->imageTableWidget->setItem(row, 1, new QTableWidgetItem(largestInfo));
     ui->imageTableWidget->setItem(row, 2, new QTableWidgetItem(smallestInfo));
 }
@@ -195,6 +414,21 @@ void AugmentDialog::addRowFromFile(const QFileInfo &imgFile, int row)
 
 void AugmentDialog::on_generatePushButton_clicked()
 {
+    generate(false);
+}
+
+void AugmentDialog::on_dryRunPushButton_clicked()
+{
+    generate(true);
+}
+
+void AugmentDialog::generate(bool dryRun)
+{
+    if (_generateWatcher.isRunning()) {
+        qDebug() << "Augmentation is still running!";
+        return;
+    }
+
     QString method = ui->augmentationMethodComboBox->currentText();
 
     // lấy các hàng được chọn
@@ -204,145 +438,601 @@ void AugmentDialog::on_generatePushButton_clicked()
         return;
     }
 
+    EncoderProfile profile = EncoderProfile::byName(ui->encoderProfileComboBox->currentText());
+
+    if (method.contains("Policy")) {
+        runPolicyAugmentation(selectedRows, profile, dryRun);
+        return;
+    }
+
+    QStringList imagePaths;
+    QHash<QString, QString> labelPaths;
     for (const QModelIndex &index : selectedRows) {
-        int row = index.row();
-        QTableWidgetItem *item = ui->imageTableWidget->item(row, 0);
+        QTableWidgetItem *item = ui->imageTableWidget->item(index.row(), 0);
         if (!item) continue;
 
         QString imgPath = item->data(Qt::UserRole).toString();
-        QFileInfo imgFile(imgPath);
-        QString labelPath = imgFile.absolutePath() + "/" + imgFile.completeBaseName() + ".txt";
-
-        if (!QFile::exists(labelPath)) {
-            qWarning() << "No label file for" << imgFile.fileName() << "-> skipped!";
+        QString labelPath = _labelPaths.value(imgPath);
+        if (labelPath.isEmpty()) {
+            qWarning() << "No label file for" << QFileInfo(imgPath).fileName() << "-> skipped!";
             continue;
         }
+        imagePaths << imgPath;
+        labelPaths.insert(imgPath, labelPath);
+    }
 
-        if (method.contains("Tile")) {
-            // ---- Tile ----
-            QString sizeText = ui->tileSizeComboBox->currentText().trimmed();
-            QStringList parts = sizeText.split(QRegularExpression("\\s*x\\s*"));
-            if (parts.size() != 2) continue;
+    // đọc hết tham số từ UI trước khi chuyển sang worker thread
+    QVector<ImageTiler::Level> tileLevels;
+    TileQualityGate::Options tileGate;
+    if (method.contains("Tile")) {
+        // 1 kích thước như cũ, hoặc nhiều mức: "640 x 640, 1024, 640@0.5"
+        QString error;
+        if (!ImageTiler::parseLevels(ui->tileSizeComboBox->currentText(), &tileLevels, &error)
+            || !TileQualityGate::parse(ui->tileGateLineEdit->text(), &tileGate, &error)) {
+            QMessageBox::warning(this, tr("Tile"), error);
+            return;
+        }
+    }
+    bool minCover = ui->minCoverCheckBox->isChecked();
+    QString manifestDir = _scanFolder;
+
+    if (dryRun) {
+        if (imagePaths.isEmpty()) return;
+        // cùng hình học/tên như khi ghi thật; Tile decode từng ảnh nhưng encode song song, Flip/Rotate chạy tuần tự
+        bool tile = method.contains("Tile");
+        QString note = tile && tileGate.pixelChecks()
+                           ? tr("upper bound: the tile quality gate also drops tiles by pixel content")
+                           : QString();
+        startDryRun([=]() {
+            QVector<VirtualSample> samples;
+            for (const QString &imgPath : imagePaths)
+                samples += virtualSamplesFor(imgPath, labelPaths.value(imgPath), manifestDir, method, tileLevels,
+                                             minCover, tileGate);
+            return samples;
+        }, imagePaths.size(), profile, 1, tile ? QThread::idealThreadCount() : 1, note);
+        return;
+    }
 
-            int tileW = parts[0].trimmed().toInt();
-            int tileH = parts[1].trimmed().toInt();
+    if (ui->virtualCheckBox->isChecked()) {
+        if (imagePaths.isEmpty()) return;
+        QString manifestPath = AugmentManifest::defaultPath(manifestDir);
+        _progress.start(imagePaths.size());
+        startGeneration(QtConcurrent::run([=]() {
+            QVector<VirtualSample> samples;
+            for (const QString &imgPath : imagePaths)
+                samples += virtualSamplesFor(imgPath, labelPaths.value(imgPath), manifestDir, method, tileLevels,
+                                             minCover, tileGate);
+            writeManifest(manifestPath, samples);
+        }));
+        return;
+    }
 
-            ImageTiler tiler(imgPath, labelPath);
-            tiler.setTileSize(QSize(tileW, tileH));
-            tiler.setOutputDir(imgFile.absolutePath());
-            tiler.process();
+    _progress.start(imagePaths.size(), method.contains("Tile") ? ImageTiler::progressStages()
+                                                               : AugmentRunner::progressStages());
+
+    startGeneration(QtConcurrent::run([=]() {
+        EncodeStats encodeStats;
+        TileQualityGate::Stats gateStats;
+        int tiles = 0, greedyTiles = 0;
+        for (const QString &imgPath : imagePaths) {
+            QFileInfo imgFile(imgPath);
+            QString labelPath = labelPaths.value(imgPath);
+
+            if (method.contains("Tile")) {
+                // ---- Tile ----
+                ImageTiler tiler(imgPath, labelPath);
+                tiler.setLevels(tileLevels);
+                tiler.setOutputDir(imgFile.absolutePath());
+                tiler.setEncoderProfile(profile);
+                tiler.setPlacement(minCover ? ImageTiler::Placement::MinCover
+                                            : ImageTiler::Placement::Greedy);
+                tiler.setQualityGate(tileGate);
+                tiler.setProgress(&_progress);
+                tiler.process();
+                encodeStats.merge(tiler.encodeStats());
+                gateStats.merge(tiler.qualityStats());
+                tiles += tiler.report().tiles;
+                greedyTiles += tiler.report().greedyTiles;
+            }
+            else if (method.contains("Rotate 90")) {
+                // ---- Rotate 90 ----
+                writeTransformed(imgPath, labelPath, AugmentOp::Rotate90, "_R90", profile, encodeStats);
+            }
+            else if (method.contains("Rotate -90")) {
+                // ---- Rotate -90 ----
+                writeTransformed(imgPath, labelPath, AugmentOp::RotateMinus90, "_R-90", profile, encodeStats);
+            }
+            else if (method.contains("Flip Vertical")) {
+                // ---- Flip Vertical ----
+                writeTransformed(imgPath, labelPath, AugmentOp::FlipVertical, "_FV", profile, encodeStats);
+            }
+            else if (method.contains("Flip Horizontal")) {
+                // ---- Flip Horizontal ----
+                writeTransformed(imgPath, labelPath, AugmentOp::FlipHorizontal, "_FH", profile, encodeStats);
+            }
         }
-        else if (method.contains("Rotate 90")) {
-            // ---- Rotate 90 ----
-            QImage img(imgPath);
-            QTransform transform;
-            transform.rotate(90);
-            QImage rotated = img.transformed(transform);
-
-            QString newImgPath = imgFile.absolutePath() + "/" + imgFile.completeBaseName() + "_R90." + imgFile.suffix();
-            rotated.save(newImgPath);
-
-            // Xử lý bbox
-            qDebug() << "Rotated 90 saved to:" << newImgPath;
+
+        if (method.contains("Tile") && minCover && greedyTiles > 0) {
+            qDebug() << "Min cover tiling:" << tiles << "tiles vs" << greedyTiles << "greedy ("
+                     << QString::number(100.0 * (greedyTiles - tiles) / greedyTiles, 'f', 1) << "% fewer)";
         }
-        else if (method.contains("Rotate -90")) {
-            // ---- Rotate -90 ----
-            QImage img(imgPath);
-            QTransform transform;
-            transform.rotate(-90);
-            QImage rotated = img.transformed(transform);
-
-            QString newImgPath = imgFile.absolutePath() + "/" + imgFile.completeBaseName() + "_R-90." + imgFile.suffix();
-            rotated.save(newImgPath);
-
-            // xử lý bbox
-            qDebug() << "Rotated -90 saved to:" << newImgPath;
+        if (method.contains("Tile"))
+            qDebug() << gateStats.summary();
+        qDebug() << encodeStats.summary(profile.name);
+    }));
+}
+
+void AugmentDialog::startGeneration(const QFuture<void> &future)
+{
+    ui->generatePushButton->setEnabled(false);
+    ui->generateProgressBar->setValue(0);
+    ui->generateProgressBar->setVisible(true);
+    ui->progressLabel->setVisible(true);
+    _progressMonitor->start();
+    _generateWatcher.setFuture(future);
+}
+
+void AugmentDialog::startDryRun(const std::function<QVector<VirtualSample>()> &plan, int planItems,
+                                const EncoderProfile &profile, int decodeThreads, int encodeThreads,
+                                const QString &note)
+{
+    DryRunEstimator estimator;
+    estimator.setEncoderProfile(profile);
+    estimator.setThreads(decodeThreads, encodeThreads);
+    estimator.setProgress(&_progress);
+
+    _estimateNote = note;
+    _dryRunning = true;
+    _progress.start(planItems, DryRunEstimator::progressStages()); // estimator cộng thêm total theo số ảnh nguồn
+    startGeneration(QtConcurrent::run([this, plan, estimator]() mutable {
+        _estimate = estimator.estimate(plan());
+    }));
+}
+
+void AugmentDialog::generationFinished()
+{
+    _progress.finish();
+    _progressMonitor->stop();
+    ui->generatePushButton->setEnabled(true);
+
+    // thư mục được chọn trong lúc worker chạy (loadImageList đã hoãn lại)
+    QString pendingFolder = _pendingScanFolder;
+    _pendingScanFolder.clear();
+
+    if (_dryRunning) {
+        // giữ nguyên bảng và lựa chọn để bấm Generate ngay sau khi xem ước lượng
+        _dryRunning = false;
+        QString text = _estimate.summary();
+        if (!_estimateNote.isEmpty())
+            text += " (" + _estimateNote + ")";
+        ui->progressLabel->setText(text);
+        if (!pendingFolder.isEmpty())
+            loadImageList(pendingFolder);
+        QMessageBox::information(this, tr("Dry Run"), text);
+        return;
+    }
+    qDebug() << "Augmentation done!" << _progressMonitor->last().text();
+    loadImageList(pendingFolder.isEmpty() ? _dataSrc->sourceDir() : pendingFolder);   // reload bảng
+}
+
+void AugmentDialog::updateProgress(const ProgressChannel::Snapshot &snapshot)
+{
+    ui->generateProgressBar->setValue(snapshot.percent());
+    ui->progressLabel->setText(snapshot.text());
+}
+
+QVector<VirtualSample> AugmentDialog::virtualSamplesFor(const QString &imgPath, const QString &labelPath,
+                                                        const QString &manifestDir, const QString &method,
+                                                        const QVector<ImageTiler::Level> &tileLevels,
+                                                        bool minCover, const TileQualityGate::Options &tileGate)
+{
+    QFileInfo imgFile(imgPath);
+    QVector<VirtualSample> samples;
+
+    if (method.contains("Tile")) {
+        // chỉ đọc header lấy kích thước; cùng hình học/tên tile như ImageTiler::process()
+        QImageReader reader(imgPath);
+        reader.setAutoTransform(true);
+        QSize size = reader.size();
+        if (reader.transformation() & QImageIOHandler::TransformationRotate90)
+            size.transpose();
+        if (!size.isValid()) {
+            qWarning() << "Cannot read image size:" << imgPath;
+            _progress.itemFailed();
+            return samples;
         }
-        else if (method.contains("Flip Vertical")) {
-            // ---- Flip Vertical ----
-            QImage img(imgPath);
-            QImage flipped = img.mirrored(false, true); // flip vertical
-
-            QString newImgPath = imgFile.absolutePath() + "/" + imgFile.completeBaseName() + "_FV." + imgFile.suffix();
-            flipped.save(newImgPath);
-
-            // xử lý label
-            QFile labelFile(labelPath);
-            if (labelFile.open(QIODevice::ReadOnly)) {
-                QList<QString> newLines;
-                QTextStream in(&labelFile);
-                while (!in.atEnd()) {
-                    QString line = in.readLine().trimmed();
-                    if (line.isEmpty()) continue;
-
-                    QTextStream ls(&line, QIODevice::ReadOnly);
-                    int cls; double xc, yc, w, h;
-                    ls >> cls >> xc >> yc >> w >> h;
-
-                    yc = 1.0 - yc; // flip theo trục ngang
-
-                    newLines.append(QString("%1 %2 %3 %4 %5")
-                                        .arg(cls).arg(xc).arg(yc).arg(w).arg(h));
-                }
-                labelFile.close();
-
-                QString newLabelPath = imgFile.absolutePath() + "/" + imgFile.completeBaseName() + "_FV.txt";
-                QFile outFile(newLabelPath);
-                if (outFile.open(QIODevice::WriteOnly)) {
-                    QTextStream out(&outFile);
-                    for (const QString &l : newLines) out << l << "\n";
-                }
-            }
 
-            qDebug() << "Flipped Vertical saved to:" << newImgPath;
+        ImageTiler tiler(imgPath, labelPath);
+        tiler.setLevels(tileLevels);
+        tiler.setPlacement(minCover ? ImageTiler::Placement::MinCover : ImageTiler::Placement::Greedy);
+        tiler.setQualityGate(tileGate); // chỉ phần visible: sample ảo không decode nên không xét pixel
+        for (const auto &tile : tiler.outputTiles(size.width(), size.height())) {
+            VirtualSample s;
+            s.name = AugmentManifest::sampleName(manifestDir, imgPath, tile.name);
+            s.sourcePath = imgFile.absoluteFilePath();
+            s.scale = tile.scale;
+            s.crop = tile.roi;
+            s.boxes = tile.boxes;
+            samples.push_back(s);
         }
-        else if (method.contains("Flip Horizontal")) {
-            // ---- Flip Horizontal ----
-            QImage img(imgPath);
-            QImage flipped = img.mirrored(true, false); // flip horizontal
-
-            QString newImgPath = imgFile.absolutePath() + "/" + imgFile.completeBaseName() + "_FH." + imgFile.suffix();
-            flipped.save(newImgPath);
-
-            // xử lý label
-            QFile labelFile(labelPath);
-            if (labelFile.open(QIODevice::ReadOnly)) {
-                QList<QString> newLines;
-                QTextStream in(&labelFile);
-                while (!in.atEnd()) {
-                    QString line = in.readLine().trimmed();
-                    if (line.isEmpty()) continue;
-
-                    QTextStream ls(&line, QIODevice::ReadOnly);
-                    int cls; double xc, yc, w, h;
-                    ls >> cls >> xc >> yc >> w >> h;
-
-                    xc = 1.0 - xc; // flip theo trục dọc
-
-                    newLines.append(QString("%1 %2 %3 %4 %5")
-                                        .arg(cls).arg(xc).arg(yc).arg(w).arg(h));
-                }
-                labelFile.close();
-
-                QString newLabelPath = imgFile.absolutePath() + "/" + imgFile.completeBaseName() + "_FH.txt";
-                QFile outFile(newLabelPath);
-                if (outFile.open(QIODevice::WriteOnly)) {
-                    QTextStream out(&outFile);
-                    for (const QString &l : newLines) out << l << "\n";
-                }
-            }
+    } else {
+        static const QList<QPair<QString, QPair<AugmentOp, QString>>> ops = {
+            {"Rotate 90", {AugmentOp::Rotate90, "_R90"}},
+            {"Rotate -90", {AugmentOp::RotateMinus90, "_R-90"}},
+            {"Flip Vertical", {AugmentOp::FlipVertical, "_FV"}},
+            {"Flip Horizontal", {AugmentOp::FlipHorizontal, "_FH"}},
+        };
+        for (const auto &op : ops) {
+            if (!method.contains(op.first)) continue;
+            VirtualSample s;
+            s.name = AugmentManifest::sampleName(manifestDir, imgPath, imgFile.completeBaseName() + op.second.second);
+            s.sourcePath = imgFile.absoluteFilePath();
+            s.steps = {{op.second.first}};
+            s.boxes = YoloLabel::read(labelPath);
+            AugmentPolicy::transformBoxes(s.steps.first(), s.boxes);
+            samples.push_back(s);
+            break;
+        }
+    }
+
+    _progress.itemDone();
+    return samples;
+}
+
+void AugmentDialog::writeManifest(const QString &manifestPath, const QVector<VirtualSample> &samples)
+{
+    QString error;
+    if (!AugmentManifest::merge(manifestPath, samples, &error)) {
+        qWarning() << error;
+        return;
+    }
+    qDebug() << "Virtual augmentation:" << samples.size() << "samples ->" << manifestPath
+             << "(" << QFileInfo(manifestPath).size() << "bytes )";
+}
+
+void AugmentDialog::writeTransformed(const QString &imgPath, const QString &labelPath, AugmentOp op,
+                                     const QString &suffix, const EncoderProfile &profile,
+                                     EncodeStats &encodeStats)
+{
+    cv::Mat img;
+    {
+        ProgressChannel::StageTimer t(&_progress, AugmentRunner::StageDecode);
+        img = cv::imread(imgPath.toStdString());
+    }
+    if (img.empty()) {
+        qWarning() << "Cannot read image:" << imgPath;
+        _progress.itemFailed();
+        return;
+    }
+
+    // dùng chung code transform với chế độ Random Policy (ảnh + bbox)
+    QVector<BBox> boxes = YoloLabel::read(labelPath);
+    {
+        ProgressChannel::StageTimer t(&_progress, AugmentRunner::StageTransform);
+        AugmentPolicy::applyStep({op}, img, boxes);
+    }
+
+    QFileInfo imgFile(imgPath);
+    QString base = imgFile.absolutePath() + "/" + imgFile.completeBaseName() + suffix;
+    QString newImgPath;
+    qint64 encodeNs = 0;
+    qint64 bytes = profile.write(img, base, imgFile.suffix(), &newImgPath, &encodeNs);
+    _progress.stageDone(AugmentRunner::StageEncode, encodeNs);
+    if (bytes < 0) {
+        qWarning() << "Cannot write image:" << base;
+        _progress.itemFailed();
+        return;
+    }
+    encodeStats.add(bytes, encodeNs);
+    QString newLabelPath = YoloLabel::outputLabelPathFor(base, imgPath, labelPath);
+    if (!YoloLabel::write(newLabelPath, boxes)) {
+        qWarning() << "Cannot write label:" << newLabelPath;
+        _progress.itemFailed();
+        return;
+    }
+    _progress.itemDone(bytes);
+
+    qDebug() << suffix << "saved to:" << newImgPath;
+}
+
+void AugmentDialog::runPolicyAugmentation(const QModelIndexList &selectedRows, const EncoderProfile &profile,
+                                          bool dryRun)
+{
+    QString error;
+    AugmentPolicy policy = AugmentPolicy::fromString(ui->policyLineEdit->text(), &error);
+    if (policy.isEmpty()) {
+        QMessageBox::warning(this, tr("Random Policy"), error);
+        return;
+    }
+    policy.setSeed(quint64(ui->seedSpinBox->value()));
+    policy.setVariantsPerImage(ui->variantsSpinBox->value());
+
+    QStringList imagePaths;
+    for (const QModelIndex &index : selectedRows) {
+        QTableWidgetItem *item = ui->imageTableWidget->item(index.row(), 0);
+        if (!item) continue;
+
+        QString imgPath = item->data(Qt::UserRole).toString();
+        if (!_labelPaths.contains(imgPath)) {
+            qWarning() << "No label file for" << QFileInfo(imgPath).fileName() << "-> skipped!";
+            continue;
+        }
+        imagePaths << imgPath;
+    }
+
+    AugmentRunner runner;
+    runner.setPolicy(policy);
+    runner.setKeyBase(_scanFolder);
+    runner.setEncoderProfile(profile);
+    runner.setProgress(&_progress);
+
+    QVector<AugmentRunner::Job> jobs;
+    if (ui->balanceClassesCheckBox->isChecked()) {
+        // chọn ảnh + số variant theo số box thiếu của từng class
+        // candidates rỗng nghĩa là mọi ảnh trong index -> không có ảnh có label nào được chọn thì dừng
+        if (imagePaths.isEmpty()) return;
+        QSet<int> candidates;
+        for (const QString &path : imagePaths) {
+            int id = _index.imageId(path);
+            if (id >= 0) candidates.insert(id);
+        }
+        if (candidates.isEmpty()) return;
+
+        AugmentPlanner planner(_index);
+        planner.setTargetPerClass(ui->classTargetSpinBox->value());
+        planner.setMaxVariantsPerImage(ui->variantsSpinBox->value());
+        planner.setCandidates(candidates);
+        AugmentPlanner::Plan plan = planner.plan();
+
+        for (auto it = plan.current.constBegin(); it != plan.current.constEnd(); ++it) {
+            qDebug() << "Class" << it.key() << ":" << it.value() << "->" << plan.projected.value(it.key())
+                     << "boxes";
+        }
+        jobs = plan.jobs;
+    } else {
+        jobs = runner.jobsFor(imagePaths);
+        for (auto &job : jobs)   // label có thể nằm ở labels/ thay vì cạnh ảnh
+            job.labelPath = _labelPaths.value(job.imagePath);
+    }
+
+    if (dryRun) {
+        if (jobs.isEmpty()) return;
+        // runner decode + encode song song theo số core (sharded chỉ chia cùng khối việc cho nhiều process)
+        int threads = QThread::idealThreadCount();
+        startDryRun([runner, jobs]() { return runner.virtualSamples(jobs); }, jobs.size(), profile,
+                    threads, threads, QString());
+        return;
+    }
+
+    if (ui->virtualCheckBox->isChecked()) {
+        if (jobs.isEmpty()) return;
+        QString manifestPath = AugmentManifest::defaultPath(_scanFolder);
+        _progress.start(jobs.size());
+        startGeneration(QtConcurrent::run([this, runner, jobs, manifestPath]() {
+            writeManifest(manifestPath, runner.virtualSamples(jobs));
+        }));
+        return;
+    }
+
+    if (ui->shardedCheckBox->isChecked()) {
+        if (jobs.isEmpty()) return;
+        // process khác (cùng máy hoặc máy khác mount chung thư mục) tham gia bằng Join Shards...
+        ShardCoordinator::Plan plan;
+        plan.policy = policy.toString();
+        plan.seed = policy.seed();
+        plan.encoderProfile = profile.name;
+        plan.keyBase = _scanFolder;
+        plan.jobs = jobs;
+        ShardCoordinator coordinator(ShardCoordinator::defaultDir(_scanFolder));
+        if (!coordinator.publish(plan, &error)) {
+            QMessageBox::warning(this, tr("Random Policy"), error);
+            return;
+        }
+        // cùng plan (ảnh, label, policy không đổi) đã chạy xong -> output đã có sẵn
+        if (coordinator.remainingShards() == 0) {
+            QMessageBox::information(this, tr("Random Policy"),
+                                     tr("Nothing left to run: every shard of this plan is already done in %1.\n"
+                                        "Change the images, labels or policy to run a new plan.")
+                                         .arg(coordinator.dir()));
+            return;
+        }
+        runShardWorker(coordinator.dir());
+        return;
+    }
+
+    _progress.start(0, AugmentRunner::progressStages()); // runner cộng total theo số variant
+    startGeneration(QtConcurrent::run([runner, jobs]() mutable {
+        AugmentRunner::Stats stats = runner.run(jobs);
+        qDebug() << "Policy augmentation:" << stats.written << "images from" << stats.sources
+                 << "sources," << stats.failed << "failed";
+    }));
+}
 
-            qDebug() << "Flipped Horizontal saved to:" << newImgPath;
+void AugmentDialog::runShardWorker(const QString &shardDir)
+{
+    _progress.start(0, AugmentRunner::progressStages()); // runner cộng total theo từng shard
+    startGeneration(QtConcurrent::run([this, shardDir]() {
+        ShardCoordinator coordinator(shardDir);
+        coordinator.setProgress(&_progress);
+        QString error;
+        ShardCoordinator::Report report = coordinator.runWorker(&error);
+        if (!error.isEmpty()) {
+            qWarning() << error;
+            return;
         }
+        qDebug() << "Sharded augmentation:" << report.processed << "of" << report.shards << "shards,"
+                 << report.stats.written << "images written by" << coordinator.ownerId();
+        if (report.failedShards > 0)
+            qWarning() << report.failedShards << "shards had failed images and are not done; Join Shards... retries them";
+    }));
+}
+
+void AugmentDialog::on_joinShardsPushButton_clicked()
+{
+    if (_generateWatcher.isRunning()) {
+        qDebug() << "Augmentation is still running!";
+        return;
+    }
+
+    // chọn thư mục ảnh (chứa .augment_shards) hoặc chính thư mục shard
+    QString dir = QFileDialog::getExistingDirectory(this, tr("Select Shard Folder"), _scanFolder);
+    if (dir.isEmpty())
+        return;
+    if (!QFile::exists(QDir(dir).filePath("plan.jsonl")))
+        dir = ShardCoordinator::defaultDir(dir);
+
+    ShardCoordinator::Plan plan;
+    QString error;
+    ShardCoordinator coordinator(dir);
+    if (!coordinator.load(&plan, &error)) {
+        QMessageBox::warning(this, tr("Join Shards"), error);
+        return;
     }
+    if (coordinator.remainingShards() == 0) {
+        QMessageBox::information(this, tr("Join Shards"),
+                                 tr("Nothing left to run: all %1 shards are already done.").arg(plan.shardCount()));
+        return;
+    }
+    runShardWorker(dir);
+}
+
+void AugmentDialog::on_tileGatePresetPushButton_clicked()
+{
+    ui->tileGateLineEdit->setText(TileQualityGate::suggestedSpec());
+}
 
-    qDebug() << "Augmentation done!";
-    loadImageList(_dataSrc->sourceDir());   // reload bảng
+void AugmentDialog::updateDuplicates()
+{
+    _duplicateOf.clear();
+    _duplicateCount.clear();
+    if (_generateWatcher.isRunning()) return; // worker đang ghi _duplicateIndex
+
+    // index đã lưu của thư mục này (nếu có) được nạp lại, chưa bấm Find Duplicates lần nào thì bỏ qua
+    QString indexPath = DuplicateIndex::defaultPath(_scanFolder);
+    if (indexPath != _duplicateIndexPath) {
+        if (!_duplicateIndex.load(indexPath))
+            _duplicateIndex.clear();
+        _duplicateIndexPath = indexPath;
+    }
+    if (_duplicateIndex.size() == 0) return;
+
+    QStringList imagePaths;
+    for (const QFileInfo &imgFile : _allFiles)
+        imagePaths << imgFile.absoluteFilePath();
+    _duplicateOf = _duplicateIndex.duplicates(imagePaths, ui->duplicateRadiusSpinBox->value());
+    for (const QString &keeper : _duplicateOf)
+        _duplicateCount[keeper]++;
 }
 
+void AugmentDialog::on_findDuplicatesPushButton_clicked()
+{
+    if (_generateWatcher.isRunning()) {
+        qDebug() << "Augmentation is still running!";
+        return;
+    }
+    if (_scanWatcher.isRunning()) {
+        qDebug() << "Still scanning the folder!";
+        return;
+    }
+
+    QStringList imagePaths;
+    for (const QFileInfo &imgFile : _allFiles)
+        imagePaths << imgFile.absoluteFilePath();
+    if (imagePaths.isEmpty()) return;
+
+    QString indexPath = DuplicateIndex::defaultPath(_scanFolder);
+    if (indexPath != _duplicateIndexPath && !_duplicateIndex.load(indexPath))
+        _duplicateIndex.clear();
+    _duplicateIndexPath = indexPath;
+    _duplicateIndex.setProgress(&_progress);
+
+    // chỉ ảnh mới/đã đổi phải decode; xong thì bảng được quét lại và gom nhóm trong scanFinished
+    _progress.start(0, DuplicateIndex::progressStages());
+    startGeneration(QtConcurrent::run([this, imagePaths, indexPath]() {
+        _duplicateIndex.update(imagePaths);
+        if (!_duplicateIndex.save(indexPath))
+            qWarning() << "Cannot save duplicate index" << indexPath;
+    }));
+}
+
+void AugmentDialog::on_deselectDuplicatesPushButton_clicked()
+{
+    if (_duplicateOf.isEmpty()) {
+        qDebug() << "No near-duplicates found, press Find Duplicates first!";
+        return;
+    }
+
+    // bỏ chọn bản trùng, ảnh đầu nhóm vẫn được chọn
+    QItemSelection duplicates;
+    for (const QModelIndex &index : ui->imageTableWidget->selectionModel()->selectedRows()) {
+        QTableWidgetItem *item = ui->imageTableWidget->item(index.row(), 0);
+        if (item && _duplicateOf.contains(item->data(Qt::UserRole).toString()))
+            duplicates.select(index, index);
+    }
+    ui->imageTableWidget->selectionModel()->select(duplicates,
+                                                   QItemSelectionModel::Deselect | QItemSelectionModel::Rows);
+}
+
+void AugmentDialog::on_exportPushButton_clicked()
+{
+    if (_generateWatcher.isRunning()) {
+        qDebug() << "Augmentation is still running!";
+        return;
+    }
+
+    QString error;
+    QVector<DatasetExporter::Split> splits = DatasetExporter::parseSplits(ui->splitRatioLineEdit->text(), &error);
+    if (splits.isEmpty()) {
+        QMessageBox::warning(this, tr("Export Split"), error);
+        return;
+    }
+
+    // hàng được chọn; không chọn hàng nào thì xuất mọi hàng đang có trong bảng (sau khi lọc)
+    QStringList imagePaths;
+    QModelIndexList selectedRows = ui->imageTableWidget->selectionModel()->selectedRows();
+    if (selectedRows.isEmpty()) {
+        for (int row = 0; row < ui->imageTableWidget->rowCount(); ++row) {
+            QTableWidgetItem *item = ui->imageTableWidget->item(row, 0);
+            if (item) imagePaths << item->data(Qt::UserRole).toString();
+        }
+    } else {
+        for (const QModelIndex &index : selectedRows) {
+            QTableWidgetItem *item = ui->imageTableWidget->item(index.row(), 0);
+            if (item) imagePaths << item->data(Qt::UserRole).toString();
+        }
+    }
+    if (imagePaths.isEmpty()) {
+        qDebug() << "No image to export!";
+        return;
+    }
+
+    QString outDir = QFileDialog::getExistingDirectory(this, tr("Select Export Folder"));
+    if (outDir.isEmpty())
+        return;
+
+    DatasetExporter exporter;
+    exporter.setOutputDir(outDir);
+    exporter.setSplits(splits);
+    exporter.setStrategy(ui->stratifiedCheckBox->isChecked() ? DatasetExporter::Strategy::Stratified
+                                                             : DatasetExporter::Strategy::Ratio);
+    exporter.setSeed(quint64(ui->seedSpinBox->value()));
+    exporter.setProgress(&_progress);
+
+    // worker dùng bản chụp index (implicit sharing, không copy sâu): GUI có thể quét lại thư mục trong lúc xuất
+    DatasetIndex index = _index;
+    _progress.start(0, DatasetExporter::progressStages());
+    startGeneration(QtConcurrent::run([exporter, imagePaths, index]() mutable {
+        exporter.run(imagePaths, index);
+    }));
+}
 
 void AugmentDialog::on_deletePushButton_clicked()
 {
+    if (_generateWatcher.isRunning()) {
+        qDebug() << "Augmentation is still running!";
+        return;
+    }
+
     QModelIndexList selectedRows = ui->imageTableWidget->selectionModel()->selectedRows();
     if (selectedRows.isEmpty()) {
         qDebug() << "No image selected to delete!";
@@ -361,19 +1051,18 @@ void AugmentDialog::on_deletePushButton_clicked()
         if (!item) continue;
 
         QString imgPath = item->data(Qt::UserRole).toString();
-        QFileInfo imgFile(imgPath);
-        QString labelPath = imgFile.absolutePath() + "/" + imgFile.completeBaseName() + ".txt";
+        QString labelPath = _labelPaths.value(imgPath);
 
         if (QFile::exists(imgPath)) {
             QFile::remove(imgPath);
             qDebug() << "Deleted image:" << imgPath;
         }
-        if (QFile::exists(labelPath)) {
-            QFile::remove(labelPath);
+        if (!labelPath.isEmpty() && QFile::remove(labelPath)) {
             qDebug() << "Deleted label:" << labelPath;
         }
-        loadImageList(_dataSrc->sourceDir());
     }
+    // quét lại sau khi xoá hết: bảng được dựng lại dần nên không thể đọc hàng giữa chừng
+    loadImageList(_dataSrc->sourceDir());
 }
 
 void AugmentDialog::updateSelectionCount()
@@ -2,6 +2,21 @@
 #define AUGMENTDIALOG_H
 #include "../../base/datasource.h"
 #include <QDialog>
+#include <QModelIndex>
+#include <QFutureWatcher>
+#include <QTimer>
+#include "datasetindex.h"
+#include "boxindex.h"
+#include "augmentpolicy.h"
+#include "encoderprofile.h"
+#include "progresschannel.h"
+#include "virtualaugment.h"
+#include "imagetiler.h"
+#include "datasetscanner.h"
+#include "duplicateindex.h"
+#include "dryrunestimator.h"
+#include <functional>
+#include <atomic>
 
 namespace Ui {
 class AugmentDialog;
@@ -19,16 +34,67 @@ private slots:
     void openFileDialog();
     void on_closePushButton_clicked();
     void on_generatePushButton_clicked();
+    void on_dryRunPushButton_clicked();
     void on_deletePushButton_clicked();
+    void on_exportPushButton_clicked();
+    void on_joinShardsPushButton_clicked();
+    void on_tileGatePresetPushButton_clicked();
+    void on_findDuplicatesPushButton_clicked();
+    void on_deselectDuplicatesPushButton_clicked();
     void updateSelectionCount();
     void applyFilter();
+    void generationFinished();
+    void scanFinished();
+    void updateProgress(const ProgressChannel::Snapshot &snapshot);
 
 private:
     Ui::AugmentDialog *ui;
     DataSource* _dataSrc;
     void loadImageList(const QString &folder);
     QFileInfoList _allFiles;
+    QHash<QString, QString> _labelPaths;   // ảnh -> label do DatasetScanner ghép; không có key -> chưa có label
+    QString _scanFolder;
+    QString _pendingScanFolder;            // chọn trong lúc worker chạy -> quét khi chạy xong
+    QFutureWatcher<int> _scanWatcher;      // kết quả = generation của lần quét
+    QVector<QFuture<int>> _staleScans;     // lần quét cũ chưa kịp dừng, chỉ đợi lúc đóng dialog
+    std::atomic<int> _scanGeneration {0};  // tăng mỗi lần quét, batch của lần quét cũ bị bỏ
+    void appendScanned(int generation, const QVector<DatasetScanner::Entry> &batch);
+    bool filterNeedsIndex() const;
+    bool matchesNameFilter(const QFileInfo &imgFile) const;
+    DatasetIndex _index;
+    QString _indexedFolder;
+    BoxIndex _boxIndex;
+    bool _boxIndexDirty = true;
+    DuplicateIndex _duplicateIndex;
+    QString _duplicateIndexPath;            // file index đang nạp trong _duplicateIndex
+    QHash<QString, QString> _duplicateOf;   // bản trùng -> ảnh giữ lại
+    QHash<QString, int> _duplicateCount;    // ảnh giữ lại -> số bản trùng
+    void updateDuplicates();
+    void updateClassFilter();
     void addRowFromFile(const QFileInfo &imgFile, int row);
+    void updateBoxColumns(int row);
+    QTimer _filterTimer;                    // gõ tên / box query: lọc lại khi ngừng gõ, không theo từng phím
+    ProgressChannel _progress;
+    ProgressMonitor *_progressMonitor;
+    QFutureWatcher<void> _generateWatcher;
+    void startGeneration(const QFuture<void> &future);
+    void generate(bool dryRun);
+    // Dry run: plan() chỉ tính hình học (sample ảo), estimator đo calibration rồi ước lượng; bảng không bị quét lại
+    void startDryRun(const std::function<QVector<VirtualSample>()> &plan, int planItems,
+                     const EncoderProfile &profile, int decodeThreads, int encodeThreads, const QString &note);
+    bool _dryRunning = false;
+    DryRunEstimator::Estimate _estimate;
+    QString _estimateNote;
+    QVector<VirtualSample> virtualSamplesFor(const QString &imgPath, const QString &labelPath,
+                                             const QString &manifestDir, const QString &method,
+                                             const QVector<ImageTiler::Level> &tileLevels, bool minCover,
+                                             const TileQualityGate::Options &tileGate);
+    void writeManifest(const QString &manifestPath, const QVector<VirtualSample> &samples);
+    void runPolicyAugmentation(const QModelIndexList &selectedRows, const EncoderProfile &profile, bool dryRun);
+    void runShardWorker(const QString &shardDir);
+    void writeTransformed(const QString &imgPath, const QString &labelPath, AugmentOp op,
+                          const QString &suffix, const EncoderProfile &profile,
+                          EncodeStats &encodeStats);
 
 };
 
@@ -0,0 +1,118 @@
+#include "augmentplanner.h"
+#include <QHash>
+#include <QDebug>
+#include <algorithm>
+#include <limits>
+
+AugmentPlanner::AugmentPlanner(const DatasetIndex &index)
+    : m_index(index)
+{ }
+
+void AugmentPlanner::setTargetPerClass(int target) {
+    m_targetPerClass = target;
+}
+
+void AugmentPlanner::setTarget(int cls, int target) {
+    m_targets[cls] = target;
+}
+
+void AugmentPlanner::setMaxVariantsPerImage(int n) {
+    m_maxVariantsPerImage = std::max(1, n);
+}
+
+void AugmentPlanner::setCandidates(const QSet<int> &imageIds) {
+    m_candidates = imageIds;
+}
+
+int AugmentPlanner::targetFor(int cls) const
+{
+    return m_targets.value(cls, m_targetPerClass);
+}
+
+double AugmentPlanner::score(int imageId, const QMap<int, int> &deficit) const
+{
+    // lợi: số box lấp được phần thiếu; hại: số box làm class đã đủ bị dư thêm
+    double gain = 0.0, waste = 0.0;
+    const auto &counts = m_index.image(imageId).classCounts;
+    for (auto it = counts.constBegin(); it != counts.constEnd(); ++it) {
+        int need = std::max(0, deficit.value(it.key(), 0));
+        gain  += std::min(it.value(), need);
+        waste += std::max(0, it.value() - need);
+    }
+    return gain - 0.5 * waste;
+}
+
+AugmentPlanner::Plan AugmentPlanner::plan() const
+{
+    Plan result;
+    QMap<int, int> deficit;
+    QHash<int, QVector<int>> candidatesByClass;
+
+    for (int cls : m_index.classIds()) {
+        int cur = m_index.boxCount(cls);
+        result.current[cls] = cur;
+        result.projected[cls] = cur;
+        deficit[cls] = targetFor(cls) - cur;
+
+        QVector<int> ids = m_index.imagesWithClass(cls);
+        if (!m_candidates.isEmpty()) {
+            ids.erase(std::remove_if(ids.begin(), ids.end(), [this](int id) {
+                          return !m_candidates.contains(id);
+                      }), ids.end());
+        }
+        candidatesByClass.insert(cls, ids);
+    }
+
+    QHash<int, int> multiplicity;
+    QSet<int> exhausted;
+
+    // greedy: luôn bù cho class thiếu nhiều nhất bằng ảnh có điểm cao nhất
+    while (true) {
+        int cls = -1, worst = 0;
+        for (auto it = deficit.constBegin(); it != deficit.constEnd(); ++it) {
+            if (it.value() > worst && !exhausted.contains(it.key())) {
+                worst = it.value();
+                cls = it.key();
+            }
+        }
+        if (cls < 0) break;
+
+        int pick = -1;
+        double bestScore = -std::numeric_limits<double>::infinity();
+        for (int id : candidatesByClass.value(cls)) {
+            if (multiplicity.value(id, 0) >= m_maxVariantsPerImage) continue;
+            double s = score(id, deficit);
+            if (s > bestScore) {
+                bestScore = s;
+                pick = id;
+            }
+        }
+
+        if (pick < 0) {
+            exhausted.insert(cls); // không còn ảnh nào dùng được cho class này
+            continue;
+        }
+
+        // AugmentPolicy::sample() rút lại tới khi có op (chỉ rỗng khi mọi op có xác suất 0) -> mỗi variant là 1 ảnh ra
+        multiplicity[pick]++;
+        result.totalVariants++;
+
+        const auto &counts = m_index.image(pick).classCounts;
+        for (auto it = counts.constBegin(); it != counts.constEnd(); ++it) {
+            deficit[it.key()] -= it.value();
+            result.projected[it.key()] += it.value();
+        }
+    }
+
+    QList<int> ids = multiplicity.keys();
+    std::sort(ids.begin(), ids.end());
+    for (int id : ids) {
+        const auto &entry = m_index.image(id);
+        result.jobs.push_back({entry.imagePath, entry.labelPath, multiplicity.value(id)});
+    }
+
+    if (!exhausted.isEmpty())
+        qDebug() << "AugmentPlanner: cannot reach target for classes" << exhausted.values();
+
+    return result;
+}
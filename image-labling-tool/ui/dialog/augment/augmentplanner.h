@@ -0,0 +1,41 @@
+#ifndef AUGMENTPLANNER_H
+#define AUGMENTPLANNER_H
+
+#include <QMap>
+#include <QSet>
+#include <QVector>
+#include "datasetindex.h"
+#include "augmentrunner.h"
+
+// Chọn ảnh nguồn + số variant cho mỗi ảnh để số box mỗi class đạt mục tiêu
+class AugmentPlanner
+{
+public:
+    struct Plan {
+        QVector<AugmentRunner::Job> jobs;
+        QMap<int, int> current;   // class -> số box hiện có
+        QMap<int, int> projected; // class -> số box sau khi augment theo plan
+        int totalVariants {0};
+    };
+
+    explicit AugmentPlanner(const DatasetIndex &index);
+
+    void setTargetPerClass(int target); // áp dụng cho mọi class chưa có target riêng
+    void setTarget(int cls, int target);
+    void setMaxVariantsPerImage(int n);
+    void setCandidates(const QSet<int> &imageIds); // rỗng -> mọi ảnh trong index
+
+    Plan plan() const;
+
+private:
+    int targetFor(int cls) const;
+    double score(int imageId, const QMap<int, int> &deficit) const;
+
+    const DatasetIndex &m_index;
+    QMap<int, int> m_targets;
+    QSet<int> m_candidates;
+    int m_targetPerClass {0};
+    int m_maxVariantsPerImage {8};
+};
+
+#endif // AUGMENTPLANNER_H
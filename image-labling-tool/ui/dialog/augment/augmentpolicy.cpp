@@ -0,0 +1,300 @@
+#include "augmentpolicy.h"
+#include <QRegularExpression>
+#include <QStringList>
+#include <algorithm>
+
+namespace {
+
+quint64 mix64(quint64 z)
+{
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// FNV-1a: không dùng qHash vì qHash có seed ngẫu nhiên theo process
+quint64 fnv1a(const QByteArray &data)
+{
+    quint64 h = 0xcbf29ce484222325ULL;
+    for (char c : data) {
+        h ^= quint8(c);
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+struct OpInfo {
+    AugmentOp op;
+    const char *name;
+    bool hasMagnitude;
+};
+
+const OpInfo kOps[] = {
+    { AugmentOp::FlipHorizontal, "fliph",      false },
+    { AugmentOp::FlipVertical,   "flipv",      false },
+    { AugmentOp::Rotate90,       "rot90",      false },
+    { AugmentOp::RotateMinus90,  "rot-90",     false },
+    { AugmentOp::Brightness,     "brightness", true  },
+    { AugmentOp::Contrast,       "contrast",   true  },
+    { AugmentOp::Blur,           "blur",       true  },
+    { AugmentOp::Noise,          "noise",      true  },
+};
+
+const OpInfo *findOp(AugmentOp op)
+{
+    for (const auto &info : kOps)
+        if (info.op == op) return &info;
+    return nullptr;
+}
+
+}
+
+// --- PolicyRng ---
+
+quint64 PolicyRng::next()
+{
+    m_state += 0x9e3779b97f4a7c15ULL;
+    return mix64(m_state);
+}
+
+double PolicyRng::uniform()
+{
+    return double(next() >> 11) * (1.0 / 9007199254740992.0); // 2^-53
+}
+
+double PolicyRng::uniform(double lo, double hi)
+{
+    return lo + (hi - lo) * uniform();
+}
+
+// --- AugmentPolicy ---
+
+QString AugmentPolicy::opName(AugmentOp op)
+{
+    const OpInfo *info = findOp(op);
+    return info ? QString::fromLatin1(info->name) : QString();
+}
+
+bool AugmentPolicy::opFromName(const QString &name, AugmentOp *op)
+{
+    for (const auto &info : kOps) {
+        if (name.compare(QLatin1String(info.name), Qt::CaseInsensitive) == 0) {
+            if (op) *op = info.op;
+            return true;
+        }
+    }
+    return false;
+}
+
+AugmentPolicy AugmentPolicy::fromString(const QString &spec, QString *error)
+{
+    AugmentPolicy policy;
+    const QStringList entries = spec.split(QRegularExpression("[;,]"), Qt::SkipEmptyParts);
+
+    for (const QString &entry : entries) {
+        QStringList parts = entry.trimmed().split(':');
+        if (parts.isEmpty() || parts[0].trimmed().isEmpty()) continue;
+
+        PolicyOp p;
+        if (!opFromName(parts[0].trimmed(), &p.op)) {
+            if (error) *error = QString("Unknown op: %1").arg(parts[0].trimmed());
+            return AugmentPolicy();
+        }
+
+        bool ok = true;
+        if (parts.size() >= 2) {
+            p.probability = parts[1].toDouble(&ok);
+            if (!ok || p.probability < 0.0 || p.probability > 1.0) {
+                if (error) *error = QString("Invalid probability in: %1").arg(entry.trimmed());
+                return AugmentPolicy();
+            }
+        }
+
+        if (findOp(p.op)->hasMagnitude) {
+            if (parts.size() != 4) {
+                if (error) *error = QString("Op needs <min>:<max> magnitude: %1").arg(entry.trimmed());
+                return AugmentPolicy();
+            }
+            bool okMin = false, okMax = false;
+            p.minMagnitude = parts[2].toDouble(&okMin);
+            p.maxMagnitude = parts[3].toDouble(&okMax);
+            if (!okMin || !okMax) {
+                if (error) *error = QString("Invalid magnitude in: %1").arg(entry.trimmed());
+                return AugmentPolicy();
+            }
+            if (p.minMagnitude > p.maxMagnitude)
+                std::swap(p.minMagnitude, p.maxMagnitude);
+        }
+
+        policy.m_ops.push_back(p);
+    }
+
+    if (policy.m_ops.isEmpty() && error)
+        *error = "Policy has no ops";
+    return policy;
+}
+
+QString AugmentPolicy::toString() const
+{
+    QStringList entries;
+    for (const auto &p : m_ops) {
+        QString entry = QString("%1:%2").arg(opName(p.op)).arg(p.probability);
+        if (findOp(p.op)->hasMagnitude)
+            entry += QString(":%1:%2").arg(p.minMagnitude).arg(p.maxMagnitude);
+        entries << entry;
+    }
+    return entries.join("; ");
+}
+
+void AugmentPolicy::setOps(const QVector<PolicyOp> &ops)
+{
+    m_ops = ops;
+}
+
+void AugmentPolicy::setSeed(quint64 seed)
+{
+    m_seed = seed;
+}
+
+void AugmentPolicy::setVariantsPerImage(int n)
+{
+    m_variantsPerImage = std::max(1, n);
+}
+
+quint64 AugmentPolicy::streamSeed(quint64 seed, const QString &key, int variant)
+{
+    quint64 h = mix64(seed ^ fnv1a(key.toUtf8()));
+    return mix64(h + 0x9e3779b97f4a7c15ULL * quint64(variant + 1));
+}
+
+QVector<TransformStep> AugmentPolicy::sample(const QString &key, int variant) const
+{
+    PolicyRng rng(streamSeed(m_seed, key, variant));
+    QVector<TransformStep> steps;
+
+    double totalProbability = 0.0;
+    for (const auto &p : m_ops)
+        totalProbability += std::max(0.0, p.probability);
+    if (totalProbability <= 0.0)
+        return steps; // không op nào có thể được chọn
+
+    // variant rỗng sẽ không ra ảnh nào -> rút lại tiếp trên cùng stream (vòng đầu giữ nguyên kết quả cũ)
+    const int kMaxRounds = 64;
+    for (int round = 0; round < kMaxRounds && steps.isEmpty(); ++round) {
+        for (const auto &p : m_ops) {
+            // luôn rút đủ 3 số cho mỗi op để stream không bị lệch khi đổi xác suất
+            double u = rng.uniform();
+            double m = rng.uniform(p.minMagnitude, p.maxMagnitude);
+            quint64 s = rng.next();
+            if (u < p.probability)
+                steps.push_back({p.op, m, s});
+        }
+    }
+
+    // xác suất quá nhỏ: chọn 1 op theo trọng số xác suất, vẫn xác định theo stream
+    if (steps.isEmpty()) {
+        double u = rng.uniform() * totalProbability;
+        const PolicyOp *picked = &m_ops.last();
+        for (const auto &p : m_ops) {
+            if (p.probability <= 0.0) continue;
+            picked = &p;
+            u -= p.probability;
+            if (u < 0.0) break;
+        }
+        double m = rng.uniform(picked->minMagnitude, picked->maxMagnitude);
+        steps.push_back({picked->op, m, rng.next()});
+    }
+    return steps;
+}
+
+void AugmentPolicy::apply(const QVector<TransformStep> &steps, cv::Mat &img, QVector<BBox> &boxes)
+{
+    for (const auto &step : steps)
+        applyStep(step, img, boxes);
+}
+
+void AugmentPolicy::applyStep(const TransformStep &step, cv::Mat &img, QVector<BBox> &boxes)
+{
+    transformImage(step, img);
+    transformBoxes(step, boxes);
+}
+
+void AugmentPolicy::transformBoxes(const TransformStep &step, QVector<BBox> &boxes)
+{
+    switch (step.op) {
+    case AugmentOp::FlipHorizontal:
+        for (auto &b : boxes) b.xc = 1.0f - b.xc;
+        break;
+
+    case AugmentOp::FlipVertical:
+        for (auto &b : boxes) b.yc = 1.0f - b.yc;
+        break;
+
+    case AugmentOp::Rotate90: // xoay theo chiều kim đồng hồ
+        for (auto &b : boxes) {
+            float xc = b.xc;
+            b.xc = 1.0f - b.yc;
+            b.yc = xc;
+            std::swap(b.w, b.h);
+        }
+        break;
+
+    case AugmentOp::RotateMinus90:
+        for (auto &b : boxes) {
+            float xc = b.xc;
+            b.xc = b.yc;
+            b.yc = 1.0f - xc;
+            std::swap(b.w, b.h);
+        }
+        break;
+
+    default: // các op màu/nhiễu không đổi hình học
+        break;
+    }
+}
+
+void AugmentPolicy::transformImage(const TransformStep &step, cv::Mat &img)
+{
+    switch (step.op) {
+    case AugmentOp::FlipHorizontal:
+        cv::flip(img, img, 1);
+        break;
+
+    case AugmentOp::FlipVertical:
+        cv::flip(img, img, 0);
+        break;
+
+    case AugmentOp::Rotate90:
+        cv::rotate(img, img, cv::ROTATE_90_CLOCKWISE);
+        break;
+
+    case AugmentOp::RotateMinus90:
+        cv::rotate(img, img, cv::ROTATE_90_COUNTERCLOCKWISE);
+        break;
+
+    case AugmentOp::Brightness:
+        img.convertTo(img, -1, 1.0, step.magnitude);
+        break;
+
+    case AugmentOp::Contrast:
+        img.convertTo(img, -1, step.magnitude, (1.0 - step.magnitude) * 128.0);
+        break;
+
+    case AugmentOp::Blur:
+        if (step.magnitude > 0.0)
+            cv::GaussianBlur(img, img, cv::Size(0, 0), step.magnitude);
+        break;
+
+    case AugmentOp::Noise: {
+        if (step.magnitude <= 0.0) break;
+        cv::RNG rng(step.seed);
+        cv::Mat noise(img.size(), CV_32FC(img.channels()));
+        rng.fill(noise, cv::RNG::NORMAL, 0.0, step.magnitude);
+        cv::Mat f;
+        img.convertTo(f, CV_32F);
+        f += noise;
+        f.convertTo(img, img.type());
+        break;
+    }
+    }
+}
@@ -0,0 +1,90 @@
+#ifndef AUGMENTPOLICY_H
+#define AUGMENTPOLICY_H
+
+#include <opencv2/opencv.hpp>
+#include <QString>
+#include <QVector>
+#include "yololabel.h"
+
+enum class AugmentOp {
+    FlipHorizontal,
+    FlipVertical,
+    Rotate90,
+    RotateMinus90,
+    Brightness,   // magnitude: độ lệch sáng cộng thêm (pixel)
+    Contrast,     // magnitude: hệ số tương phản
+    Blur,         // magnitude: sigma Gaussian
+    Noise         // magnitude: độ lệch chuẩn nhiễu Gaussian
+};
+
+// Một op trong policy: xác suất áp dụng + khoảng magnitude
+struct PolicyOp {
+    AugmentOp op;
+    double probability {1.0};
+    double minMagnitude {0.0};
+    double maxMagnitude {0.0};
+};
+
+// Một bước transform đã được lấy mẫu (op + magnitude cụ thể)
+struct TransformStep {
+    AugmentOp op;
+    double magnitude {0.0};
+    quint64 seed {0}; // seed riêng cho op có nhiễu
+};
+
+// RNG xác định (splitmix64) - cùng seed cho cùng kết quả trên mọi máy / số thread
+class PolicyRng
+{
+public:
+    explicit PolicyRng(quint64 seed) : m_state(seed) { }
+
+    quint64 next();
+    double uniform(); // [0, 1)
+    double uniform(double lo, double hi);
+
+private:
+    quint64 m_state;
+};
+
+class AugmentPolicy
+{
+public:
+    AugmentPolicy() = default;
+
+    // Cú pháp: "fliph:0.5; rot90:0.25; brightness:0.8:-40:40"
+    //          <op>:<probability>[:<min>:<max>]
+    static AugmentPolicy fromString(const QString &spec, QString *error = nullptr);
+    QString toString() const;
+
+    void setOps(const QVector<PolicyOp> &ops);
+    const QVector<PolicyOp> &ops() const { return m_ops; }
+    bool isEmpty() const { return m_ops.isEmpty(); }
+
+    void setSeed(quint64 seed);
+    quint64 seed() const { return m_seed; }
+
+    void setVariantsPerImage(int n);
+    int variantsPerImage() const { return m_variantsPerImage; }
+
+    // Seed cho từng (ảnh, variant): chỉ phụ thuộc seed + key, không phụ thuộc thứ tự chạy
+    static quint64 streamSeed(quint64 seed, const QString &key, int variant);
+
+    // Luôn có ít nhất 1 op, trừ khi mọi op có xác suất 0
+    QVector<TransformStep> sample(const QString &key, int variant) const;
+
+    static void apply(const QVector<TransformStep> &steps, cv::Mat &img, QVector<BBox> &boxes);
+    static void applyStep(const TransformStep &step, cv::Mat &img, QVector<BBox> &boxes);
+    // Tách riêng phần ảnh / phần bbox: manifest ảo chỉ cần bbox lúc ghi, ảnh lúc đọc
+    static void transformBoxes(const TransformStep &step, QVector<BBox> &boxes);
+    static void transformImage(const TransformStep &step, cv::Mat &img);
+
+    static QString opName(AugmentOp op);
+    static bool opFromName(const QString &name, AugmentOp *op);
+
+private:
+    QVector<PolicyOp> m_ops;
+    quint64 m_seed {0};
+    int m_variantsPerImage {1};
+};
+
+#endif // AUGMENTPOLICY_H
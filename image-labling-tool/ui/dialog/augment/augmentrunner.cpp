@@ -0,0 +1,220 @@
+#include "augmentrunner.h"
+#include <QtConcurrent/QtConcurrent>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QDir>
+#include <QDebug>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+// Mỗi ảnh nguồn chỉ decode 1 lần, các variant dùng chung; giải phóng khi variant cuối xong
+struct SourceSlot {
+    QString imagePath;
+    QString labelPath;
+    QString key;
+    std::once_flag loadOnce;
+    cv::Mat image;
+    QVector<BBox> boxes;
+    std::atomic<int> remaining {0};
+};
+
+struct WorkItem {
+    SourceSlot *slot;
+    int variant;
+};
+
+}
+
+void AugmentRunner::setPolicy(const AugmentPolicy &policy) {
+    m_policy = policy;
+}
+
+void AugmentRunner::setOutputDir(const QString &dir) {
+    m_outputDir = dir;
+}
+
+void AugmentRunner::setKeyBase(const QString &dir) {
+    m_keyBase = dir;
+}
+
+void AugmentRunner::setEncoderProfile(const EncoderProfile &profile) {
+    m_profile = profile;
+}
+
+void AugmentRunner::setMaxThreads(int n) {
+    m_maxThreads = n;
+}
+
+void AugmentRunner::setProgress(ProgressChannel *channel) {
+    m_progress = channel;
+}
+
+QStringList AugmentRunner::progressStages()
+{
+    return {"decode", "transform", "encode"};
+}
+
+QString AugmentRunner::variantSuffix(int variant)
+{
+    return QString("_A%1").arg(variant + 1);
+}
+
+QVector<AugmentRunner::Job> AugmentRunner::jobsFor(const QStringList &imagePaths) const
+{
+    QVector<Job> jobs;
+    jobs.reserve(imagePaths.size());
+    for (const QString &path : imagePaths)
+        jobs.push_back({path, YoloLabel::labelPathFor(path), m_policy.variantsPerImage()});
+    return jobs;
+}
+
+QString AugmentRunner::keyFor(const QString &imagePath, const QString &keyBase)
+{
+    if (keyBase.isEmpty())
+        return QFileInfo(imagePath).fileName();
+    return QDir(keyBase).relativeFilePath(imagePath); // luôn dùng '/'
+}
+
+QString AugmentRunner::outputBaseFor(const QString &imagePath, int variant) const
+{
+    QFileInfo info(imagePath);
+    QString dir = m_outputDir.isEmpty() ? info.absolutePath() : m_outputDir;
+    return QString("%1/%2%3").arg(dir, info.completeBaseName(), variantSuffix(variant));
+}
+
+QVector<VirtualSample> AugmentRunner::virtualSamples(const QVector<Job> &jobs) const
+{
+    QVector<VirtualSample> samples;
+    for (const auto &job : jobs) {
+        if (job.variants <= 0) continue;
+        QFileInfo info(job.imagePath);
+        QString key = keyFor(job.imagePath, m_keyBase);
+        QVector<BBox> boxes = YoloLabel::read(job.labelPath);
+
+        for (int v = 0; v < job.variants; ++v) {
+            QVector<TransformStep> steps = m_policy.sample(key, v);
+            if (steps.isEmpty()) continue; // giống run(): chỉ khi mọi op có xác suất 0
+
+            VirtualSample s;
+            s.name = AugmentManifest::sampleName(m_keyBase, job.imagePath, info.completeBaseName() + variantSuffix(v));
+            s.sourcePath = info.absoluteFilePath();
+            s.steps = steps;
+            s.boxes = boxes;
+            for (const auto &step : steps)
+                AugmentPolicy::transformBoxes(step, s.boxes);
+            samples.push_back(s);
+        }
+        if (m_progress) m_progress->itemDone();
+    }
+    return samples;
+}
+
+AugmentRunner::Stats AugmentRunner::run(const QVector<Job> &jobs)
+{
+    Stats stats;
+    QElapsedTimer timer;
+    timer.start();
+
+    if (m_policy.isEmpty()) {
+        qWarning() << "AugmentRunner: empty policy, nothing to do";
+        return stats;
+    }
+
+    if (!m_outputDir.isEmpty())
+        QDir().mkpath(m_outputDir);
+
+    std::vector<std::unique_ptr<SourceSlot>> sourceSlots;
+    QVector<WorkItem> items;
+    sourceSlots.reserve(jobs.size());
+
+    // thứ tự item theo ảnh nguồn -> mỗi lúc chỉ vài ảnh đang nằm trong RAM
+    for (const auto &job : jobs) {
+        if (job.variants <= 0) continue;
+        auto slot = std::make_unique<SourceSlot>();
+        slot->imagePath = job.imagePath;
+        slot->labelPath = job.labelPath;
+        slot->key = keyFor(job.imagePath, m_keyBase);
+        slot->remaining = job.variants;
+        for (int v = 0; v < job.variants; ++v)
+            items.push_back({slot.get(), v});
+        sourceSlots.push_back(std::move(slot));
+    }
+    stats.sources = int(sourceSlots.size());
+    if (m_progress)
+        m_progress->addTotal(items.size());
+
+    std::atomic<int> written {0}, unchanged {0}, failed {0};
+    EncodeStats encodeStats;
+
+    QThreadPool pool;
+    if (m_maxThreads > 0)
+        pool.setMaxThreadCount(m_maxThreads);
+
+    QtConcurrent::blockingMap(&pool, items, [&](const WorkItem &item) {
+        SourceSlot *slot = item.slot;
+
+        std::call_once(slot->loadOnce, [this, slot]() {
+            ProgressChannel::StageTimer t(m_progress, StageDecode);
+            slot->image = cv::imread(slot->imagePath.toStdString());
+            slot->boxes = YoloLabel::read(slot->labelPath);
+        });
+
+        QVector<TransformStep> steps = m_policy.sample(slot->key, item.variant);
+
+        if (slot->image.empty()) {
+            failed++;
+            if (m_progress) m_progress->itemFailed();
+        } else if (steps.isEmpty()) {
+            unchanged++;
+            if (m_progress) m_progress->itemDone();
+        } else {
+            cv::Mat img = slot->image.clone();
+            QVector<BBox> boxes = slot->boxes;
+            {
+                ProgressChannel::StageTimer t(m_progress, StageTransform);
+                AugmentPolicy::apply(steps, img, boxes);
+            }
+
+            QString outPath;
+            QString outBase = outputBaseFor(slot->imagePath, item.variant);
+            qint64 encodeNs = 0;
+            qint64 bytes = m_profile.write(img, outBase, QFileInfo(slot->imagePath).suffix(), &outPath, &encodeNs);
+            if (m_progress) m_progress->stageDone(StageEncode, encodeNs);
+
+            // label nguồn ở labels/<...> -> label ra cũng vào labels/<...>, không nằm cạnh ảnh ra
+            QString outLabel = YoloLabel::outputLabelPathFor(outBase, slot->imagePath, slot->labelPath);
+            if (bytes >= 0 && YoloLabel::write(outLabel, boxes)) {
+                encodeStats.add(bytes, encodeNs);
+                written++;
+                if (m_progress) m_progress->itemDone(bytes);
+            } else {
+                qWarning() << "AugmentRunner: cannot write" << outPath;
+                failed++;
+                if (m_progress) m_progress->itemFailed();
+            }
+        }
+
+        if (--slot->remaining == 0) {
+            slot->image.release();
+            slot->boxes.clear();
+        }
+    });
+
+    stats.written = written;
+    stats.unchanged = unchanged;
+    stats.failed = failed;
+    stats.bytes = encodeStats.bytes;
+    stats.encodeMs = encodeStats.encodeNs / 1000000;
+    stats.elapsedMs = timer.elapsed();
+
+    qDebug() << "AugmentRunner: sources" << stats.sources << "written" << stats.written
+             << "unchanged" << stats.unchanged << "failed" << stats.failed
+             << "in" << stats.elapsedMs << "ms";
+    qDebug() << "AugmentRunner:" << encodeStats.summary(m_profile.name);
+    return stats;
+}
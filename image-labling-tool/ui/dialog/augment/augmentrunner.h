@@ -0,0 +1,68 @@
+#ifndef AUGMENTRUNNER_H
+#define AUGMENTRUNNER_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "augmentpolicy.h"
+#include "encoderprofile.h"
+#include "progresschannel.h"
+#include "virtualaugment.h"
+
+class AugmentRunner
+{
+public:
+    struct Job {
+        QString imagePath;
+        QString labelPath;
+        int variants {1};
+    };
+
+    struct Stats {
+        int sources {0};
+        int written {0};
+        int unchanged {0}; // variant không có op (mọi op xác suất 0) -> không ghi
+        int failed {0};
+        qint64 bytes {0};
+        qint64 encodeMs {0}; // tổng thời gian encode trên mọi thread
+        qint64 elapsedMs {0};
+    };
+
+    enum ProgressStage { StageDecode, StageTransform, StageEncode };
+    static QStringList progressStages();
+
+    AugmentRunner() = default;
+
+    void setPolicy(const AugmentPolicy &policy);
+    void setOutputDir(const QString &dir); // rỗng -> ghi cạnh ảnh gốc
+    // Key RNG của ảnh = đường dẫn tương đối theo thư mục này (thư mục quét): không đổi giữa các máy,
+    // không trùng giữa 2 ảnh cùng tên ở 2 thư mục con; rỗng -> chỉ tên file
+    void setKeyBase(const QString &dir);
+    static QString keyFor(const QString &imagePath, const QString &keyBase);
+    void setEncoderProfile(const EncoderProfile &profile);
+    void setMaxThreads(int n);             // <= 0 -> theo số core
+    // mỗi variant là 1 item; runner cộng thêm total, người gọi start()/finish() channel
+    void setProgress(ProgressChannel *channel);
+
+    // Tạo job cho mỗi ảnh với số variant mặc định của policy
+    QVector<Job> jobsFor(const QStringList &imagePaths) const;
+
+    Stats run(const QVector<Job> &jobs);
+
+    // Chế độ ảo: cùng transform/seed/tên như run() nhưng chỉ tính label, không decode/ghi ảnh
+    QVector<VirtualSample> virtualSamples(const QVector<Job> &jobs) const;
+
+    static QString variantSuffix(int variant);
+
+private:
+    QString outputBaseFor(const QString &imagePath, int variant) const;
+
+    AugmentPolicy m_policy;
+    QString m_outputDir;
+    QString m_keyBase;
+    EncoderProfile m_profile {EncoderProfile::byName("source")};
+    int m_maxThreads {0};
+    ProgressChannel *m_progress {nullptr};
+};
+
+#endif // AUGMENTRUNNER_H
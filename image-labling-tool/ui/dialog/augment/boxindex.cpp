@@ -0,0 +1,455 @@
+#include "boxindex.h"
+#include "datasetindex.h"
+#include <QtConcurrent/QtConcurrent>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const char kMagic[8] = {'B', 'O', 'X', 'I', 'D', 'X', '0', '2'};
+
+struct FileHeader {
+    char magic[8];
+    quint32 imageCount;
+    quint32 boxCount;
+    quint64 signature;
+};
+
+// mỗi cột bắt đầu ở offset chia hết cho 8
+qint64 aligned(qint64 offset)
+{
+    return (offset + 7) & ~qint64(7);
+}
+
+bool compare(float a, BoxQuery::Op op, float b)
+{
+    switch (op) {
+    case BoxQuery::Less:         return a < b;
+    case BoxQuery::LessEqual:    return a <= b;
+    case BoxQuery::Greater:      return a > b;
+    case BoxQuery::GreaterEqual: return a >= b;
+    case BoxQuery::Equal:        return a == b;
+    case BoxQuery::NotEqual:     return a != b;
+    }
+    return false;
+}
+
+// vòng lặp không rẽ nhánh -> compiler vector hoá được
+template <typename ValueFn>
+void applyPredicate(quint8 *mask, quint32 n, ValueFn value, BoxQuery::Op op, float v)
+{
+    switch (op) {
+    case BoxQuery::Less:
+        for (quint32 i = 0; i < n; ++i) mask[i] &= quint8(value(i) < v);
+        break;
+    case BoxQuery::LessEqual:
+        for (quint32 i = 0; i < n; ++i) mask[i] &= quint8(value(i) <= v);
+        break;
+    case BoxQuery::Greater:
+        for (quint32 i = 0; i < n; ++i) mask[i] &= quint8(value(i) > v);
+        break;
+    case BoxQuery::GreaterEqual:
+        for (quint32 i = 0; i < n; ++i) mask[i] &= quint8(value(i) >= v);
+        break;
+    case BoxQuery::Equal:
+        for (quint32 i = 0; i < n; ++i) mask[i] &= quint8(value(i) == v);
+        break;
+    case BoxQuery::NotEqual:
+        for (quint32 i = 0; i < n; ++i) mask[i] &= quint8(value(i) != v);
+        break;
+    }
+}
+
+}
+
+// --- BoxQuery ---
+
+bool BoxQuery::parse(const QString &text, BoxQuery *query, QString *error)
+{
+    static const QRegularExpression rx("(\\w+)\\s*(<=|>=|==|!=|<|>|=)\\s*([-+]?[0-9]*\\.?[0-9]+)");
+    static const QRegularExpression separators("^[\\s,;&]*$|^\\s*and\\s*$", QRegularExpression::CaseInsensitiveOption);
+
+    BoxQuery q;
+    int last = 0;
+    auto it = rx.globalMatch(text);
+    while (it.hasNext()) {
+        QRegularExpressionMatch m = it.next();
+        if (!separators.match(text.mid(last, m.capturedStart() - last)).hasMatch()) {
+            if (error) *error = QString("Cannot parse: %1").arg(text.mid(last, m.capturedStart() - last).trimmed());
+            return false;
+        }
+        last = m.capturedEnd();
+
+        QString opText = m.captured(2);
+        Op op = opText == "<"  ? Less
+              : opText == "<=" ? LessEqual
+              : opText == ">"  ? Greater
+              : opText == ">=" ? GreaterEqual
+              : opText == "!=" ? NotEqual
+                               : Equal;
+        float value = m.captured(3).toFloat();
+
+        QString name = m.captured(1).toLower();
+        if (name == "count") {
+            q.countOp = op;
+            q.countValue = int(value);
+            continue;
+        }
+
+        Field field;
+        if (name == "class" || name == "cls") field = Class;
+        else if (name == "w" || name == "width") field = Width;
+        else if (name == "h" || name == "height") field = Height;
+        else if (name == "side") field = Side;
+        else if (name == "area") field = Area;
+        else if (name == "aspect") field = Aspect;
+        else {
+            if (error) *error = QString("Unknown field: %1").arg(m.captured(1));
+            return false;
+        }
+        q.predicates.push_back({field, op, value});
+    }
+
+    if (!separators.match(text.mid(last)).hasMatch()) {
+        if (error) *error = QString("Cannot parse: %1").arg(text.mid(last).trimmed());
+        return false;
+    }
+
+    *query = q;
+    return true;
+}
+
+// --- BoxIndex ---
+
+QString BoxIndex::defaultPath(const QString &imageDir)
+{
+    return QDir(imageDir).filePath(".box_index.bin");
+}
+
+quint64 BoxIndex::signature(const DatasetIndex &index, const QStringList &imagePaths)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    for (const QString &path : imagePaths) {
+        hash.addData(path.toUtf8());
+        int id = index.imageId(path);
+        if (id < 0) {
+            hash.addData(QByteArray(1, 0));
+            continue;
+        }
+        const DatasetIndex::ImageEntry &e = index.image(id);
+        qint64 fields[3] = {e.labelMTime, e.imageSize.width(), e.imageSize.height()};
+        hash.addData(e.labelPath.toUtf8());
+        hash.addData(QByteArray(reinterpret_cast<const char *>(fields), sizeof(fields)));
+    }
+    quint64 value = 0;
+    std::memcpy(&value, hash.result().constData(), sizeof(value));
+    return value;
+}
+
+BoxIndex::~BoxIndex()
+{
+    clear();
+}
+
+void BoxIndex::clear()
+{
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    if (m_file.isOpen())
+        m_file.close();
+
+    m_imageCount = 0;
+    m_boxCount = 0;
+    m_signature = 0;
+    m_imagePaths.clear();
+    m_idByPath.clear();
+
+    m_boxBegin.clear();
+    m_imageWidth.clear();
+    m_imageHeight.clear();
+    m_imageId.clear();
+    m_cls.clear();
+    m_xc.clear(); m_yc.clear(); m_w.clear(); m_h.clear();
+    m_wPx.clear(); m_hPx.clear();
+    bindOwned();
+}
+
+void BoxIndex::bindOwned()
+{
+    m_boxBeginPtr = m_boxBegin.data();
+    m_imageWidthPtr = m_imageWidth.data();
+    m_imageHeightPtr = m_imageHeight.data();
+    m_imageIdPtr = m_imageId.data();
+    m_clsPtr = m_cls.data();
+    m_xcPtr = m_xc.data();
+    m_ycPtr = m_yc.data();
+    m_wPtr = m_w.data();
+    m_hPtr = m_h.data();
+    m_wPxPtr = m_wPx.data();
+    m_hPxPtr = m_hPx.data();
+}
+
+void BoxIndex::build(const DatasetIndex &index, const QStringList &imagePaths)
+{
+    clear();
+
+    // chỉ gom lại box + kích thước DatasetIndex đã parse lúc quét
+    QVector<const DatasetIndex::ImageEntry *> entries;
+    entries.reserve(imagePaths.size());
+    quint32 total = 0;
+    for (const QString &path : imagePaths) {
+        int id = index.imageId(path);
+        entries << (id >= 0 ? &index.image(id) : nullptr);
+        if (id >= 0)
+            total += quint32(index.image(id).boxes.size());
+    }
+
+    m_imageCount = imagePaths.size();
+    m_boxCount = total;
+    m_signature = signature(index, imagePaths);
+    m_imagePaths = imagePaths;
+    for (int i = 0; i < m_imagePaths.size(); ++i)
+        m_idByPath.insert(m_imagePaths[i], i);
+
+    m_boxBegin.reserve(m_imageCount + 1);
+    m_imageWidth.reserve(m_imageCount);
+    m_imageHeight.reserve(m_imageCount);
+    for (auto *col : {&m_xc, &m_yc, &m_w, &m_h, &m_wPx, &m_hPx})
+        col->reserve(total);
+    m_imageId.reserve(total);
+    m_cls.reserve(total);
+
+    static const QVector<BBox> noBoxes;
+    for (int id = 0; id < entries.size(); ++id) {
+        const DatasetIndex::ImageEntry *entry = entries[id];
+        qint32 width = entry ? entry->imageSize.width() : 0;
+        qint32 height = entry ? entry->imageSize.height() : 0;
+        m_boxBegin.push_back(quint32(m_cls.size()));
+        m_imageWidth.push_back(width);
+        m_imageHeight.push_back(height);
+
+        for (const auto &b : entry ? entry->boxes : noBoxes) {
+            m_imageId.push_back(quint32(id));
+            m_cls.push_back(b.cls);
+            m_xc.push_back(b.xc);
+            m_yc.push_back(b.yc);
+            m_w.push_back(b.w);
+            m_h.push_back(b.h);
+            m_wPx.push_back(b.w * width);
+            m_hPx.push_back(b.h * height);
+        }
+    }
+    m_boxBegin.push_back(quint32(m_cls.size()));
+
+    bindOwned();
+    qDebug() << "BoxIndex: indexed" << m_boxCount << "boxes in" << m_imageCount << "images";
+}
+
+bool BoxIndex::save(const QString &path) const
+{
+    // ghi file tạm rồi đổi tên -> lần mở sau không bao giờ map phải file dở
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "BoxIndex: cannot write" << path;
+        return false;
+    }
+
+    FileHeader header;
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.imageCount = quint32(m_imageCount);
+    header.boxCount = m_boxCount;
+    header.signature = m_signature;
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    auto writeColumn = [&file](const void *data, qint64 bytes) {
+        static const char zeros[8] = {};
+        qint64 pad = aligned(file.pos()) - file.pos();
+        file.write(zeros, pad);
+        file.write(static_cast<const char *>(data), bytes);
+    };
+
+    qint64 n = m_imageCount, m = m_boxCount;
+    writeColumn(m_boxBeginPtr, (n + 1) * qint64(sizeof(quint32)));
+    writeColumn(m_imageWidthPtr, n * qint64(sizeof(qint32)));
+    writeColumn(m_imageHeightPtr, n * qint64(sizeof(qint32)));
+    writeColumn(m_imageIdPtr, m * qint64(sizeof(quint32)));
+    writeColumn(m_clsPtr, m * qint64(sizeof(qint32)));
+    for (const float *col : {m_xcPtr, m_ycPtr, m_wPtr, m_hPtr, m_wPxPtr, m_hPxPtr})
+        writeColumn(col, m * qint64(sizeof(float)));
+
+    // đường dẫn ảnh: [len:uint32][utf8]...
+    for (const QString &p : m_imagePaths) {
+        QByteArray utf8 = p.toUtf8();
+        quint32 len = quint32(utf8.size());
+        file.write(reinterpret_cast<const char *>(&len), sizeof(len));
+        file.write(utf8);
+    }
+
+    return file.commit();
+}
+
+bool BoxIndex::open(const QString &path)
+{
+    clear();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        qWarning() << "BoxIndex: cannot open" << path;
+        return false;
+    }
+
+    qint64 fileSize = m_file.size();
+    if (fileSize < qint64(sizeof(FileHeader)) || !(m_map = m_file.map(0, fileSize))) {
+        clear();
+        return false;
+    }
+
+    FileHeader header;
+    std::memcpy(&header, m_map, sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+        qWarning() << "BoxIndex: bad magic in" << path;
+        clear();
+        return false;
+    }
+
+    qint64 n = header.imageCount, m = header.boxCount;
+    qint64 offset = sizeof(FileHeader);
+    bool ok = true;
+    auto column = [&](qint64 bytes) -> const uchar * {
+        offset = aligned(offset);
+        if (offset + bytes > fileSize) {
+            ok = false;
+            return nullptr;
+        }
+        const uchar *p = m_map + offset;
+        offset += bytes;
+        return p;
+    };
+
+    m_boxBeginPtr = reinterpret_cast<const quint32 *>(column((n + 1) * 4));
+    m_imageWidthPtr = reinterpret_cast<const qint32 *>(column(n * 4));
+    m_imageHeightPtr = reinterpret_cast<const qint32 *>(column(n * 4));
+    m_imageIdPtr = reinterpret_cast<const quint32 *>(column(m * 4));
+    m_clsPtr = reinterpret_cast<const qint32 *>(column(m * 4));
+    m_xcPtr = reinterpret_cast<const float *>(column(m * 4));
+    m_ycPtr = reinterpret_cast<const float *>(column(m * 4));
+    m_wPtr = reinterpret_cast<const float *>(column(m * 4));
+    m_hPtr = reinterpret_cast<const float *>(column(m * 4));
+    m_wPxPtr = reinterpret_cast<const float *>(column(m * 4));
+    m_hPxPtr = reinterpret_cast<const float *>(column(m * 4));
+
+    for (qint64 i = 0; ok && i < n; ++i) {
+        quint32 len = 0;
+        if (offset + qint64(sizeof(len)) > fileSize) { ok = false; break; }
+        std::memcpy(&len, m_map + offset, sizeof(len));
+        offset += sizeof(len);
+        if (offset + len > fileSize) { ok = false; break; }
+        m_imagePaths << QString::fromUtf8(reinterpret_cast<const char *>(m_map + offset), int(len));
+        m_idByPath.insert(m_imagePaths.last(), int(i));
+        offset += len;
+    }
+
+    if (!ok) {
+        qWarning() << "BoxIndex: truncated file" << path;
+        clear();
+        return false;
+    }
+
+    m_imageCount = int(n);
+    m_boxCount = quint32(m);
+    m_signature = header.signature;
+    return true;
+}
+
+int BoxIndex::imageId(const QString &imagePath) const
+{
+    return m_idByPath.value(imagePath, -1);
+}
+
+void BoxIndex::countRange(const BoxQuery &query, int firstImage, int lastImage, int *counts) const
+{
+    quint32 begin = m_boxBeginPtr[firstImage];
+    quint32 n = m_boxBeginPtr[lastImage] - begin;
+
+    std::vector<quint8> mask(n, 1);
+    quint8 *mk = mask.data();
+    const qint32 *cls = m_clsPtr + begin;
+    const float *w = m_wPxPtr + begin;
+    const float *h = m_hPxPtr + begin;
+
+    for (const auto &p : query.predicates) {
+        switch (p.field) {
+        case BoxQuery::Class:
+            applyPredicate(mk, n, [cls](quint32 i) { return float(cls[i]); }, p.op, p.value);
+            break;
+        case BoxQuery::Width:
+            applyPredicate(mk, n, [w](quint32 i) { return w[i]; }, p.op, p.value);
+            break;
+        case BoxQuery::Height:
+            applyPredicate(mk, n, [h](quint32 i) { return h[i]; }, p.op, p.value);
+            break;
+        case BoxQuery::Side:
+            applyPredicate(mk, n, [w, h](quint32 i) { return std::min(w[i], h[i]); }, p.op, p.value);
+            break;
+        case BoxQuery::Area:
+            applyPredicate(mk, n, [w, h](quint32 i) { return w[i] * h[i]; }, p.op, p.value);
+            break;
+        case BoxQuery::Aspect:
+            applyPredicate(mk, n, [w, h](quint32 i) {
+                float lo = std::min(w[i], h[i]), hi = std::max(w[i], h[i]);
+                return lo > 0.0f ? hi / lo : 0.0f;
+            }, p.op, p.value);
+            break;
+        }
+    }
+
+    for (int img = firstImage; img < lastImage; ++img) {
+        int c = 0;
+        for (quint32 i = m_boxBeginPtr[img] - begin, e = m_boxBeginPtr[img + 1] - begin; i < e; ++i)
+            c += mk[i];
+        counts[img] = c;
+    }
+}
+
+QVector<int> BoxIndex::countMatches(const BoxQuery &query) const
+{
+    QVector<int> counts(m_imageCount, 0);
+    if (m_imageCount == 0) return counts;
+
+    // chia theo khối ~64k box (luôn trọn ảnh) rồi quét song song
+    const quint32 chunkBoxes = 1 << 16;
+    QVector<QPair<int, int>> chunks;
+    int first = 0;
+    for (int img = 0; img < m_imageCount; ++img) {
+        if (m_boxBeginPtr[img + 1] - m_boxBeginPtr[first] >= chunkBoxes) {
+            chunks.push_back({first, img + 1});
+            first = img + 1;
+        }
+    }
+    if (first < m_imageCount)
+        chunks.push_back({first, m_imageCount});
+
+    int *out = counts.data();
+    QtConcurrent::blockingMap(chunks, [this, &query, out](const QPair<int, int> &chunk) {
+        countRange(query, chunk.first, chunk.second, out);
+    });
+    return counts;
+}
+
+QVector<int> BoxIndex::select(const BoxQuery &query) const
+{
+    QVector<int> counts = countMatches(query);
+    QVector<int> ids;
+    for (int id = 0; id < counts.size(); ++id) {
+        if (compare(float(counts[id]), query.countOp, float(query.countValue)))
+            ids.push_back(id);
+    }
+    return ids;
+}
@@ -0,0 +1,112 @@
+#ifndef BOXINDEX_H
+#define BOXINDEX_H
+
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <vector>
+
+class DatasetIndex;
+
+// Điều kiện lọc box, vd: "side<16", "class=3 count>20", "aspect>5"
+struct BoxQuery {
+    enum Field { Class, Width, Height, Side, Area, Aspect };
+    enum Op { Less, LessEqual, Greater, GreaterEqual, Equal, NotEqual };
+
+    struct Predicate {
+        Field field;
+        Op op;
+        float value;
+    };
+
+    QVector<Predicate> predicates; // áp dụng trên từng box (AND)
+    Op countOp {GreaterEqual};     // áp dụng trên số box khớp của mỗi ảnh
+    int countValue {1};
+
+    static bool parse(const QString &text, BoxQuery *query, QString *error = nullptr);
+};
+
+// Chỉ mục dạng cột (SoA) của toàn bộ box, box của cùng ảnh nằm liền nhau.
+// Dựng từ box + kích thước ảnh DatasetIndex đã đọc; lưu ra file kèm chữ ký của dữ liệu nguồn,
+// lần sau chữ ký còn khớp thì mở lại bằng mmap, cột được đọc trực tiếp từ vùng map.
+class BoxIndex
+{
+public:
+    BoxIndex() = default;
+    ~BoxIndex();
+
+    BoxIndex(const BoxIndex &) = delete;
+    BoxIndex &operator=(const BoxIndex &) = delete;
+
+    // File index mặc định của 1 thư mục ảnh (ẩn, đuôi không phải ảnh -> scanner bỏ qua)
+    static QString defaultPath(const QString &imageDir);
+    // Đổi khi danh sách ảnh, label (đường dẫn + mtime) hoặc kích thước ảnh đổi
+    static quint64 signature(const DatasetIndex &index, const QStringList &imagePaths);
+
+    // Không đọc đĩa: ảnh không có trong index coi như không có box
+    void build(const DatasetIndex &index, const QStringList &imagePaths);
+    bool save(const QString &path) const;
+    bool open(const QString &path);
+    void clear();
+
+    bool isEmpty() const { return m_imageCount == 0; }
+    quint64 signature() const { return m_signature; }
+    int imageCount() const { return m_imageCount; }
+    quint32 boxCount() const { return m_boxCount; }
+    const QStringList &imagePaths() const { return m_imagePaths; }
+    int imageId(const QString &imagePath) const;
+
+    // Số box khớp điều kiện của mỗi ảnh (quét song song theo khối ảnh)
+    QVector<int> countMatches(const BoxQuery &query) const;
+    // Id các ảnh thoả cả điều kiện box và điều kiện count
+    QVector<int> select(const BoxQuery &query) const;
+
+    // cột, kích thước imageCount (+1 với boxBegin) hoặc boxCount
+    const quint32 *boxBegin() const { return m_boxBeginPtr; }
+    const qint32 *imageWidth() const { return m_imageWidthPtr; }
+    const qint32 *imageHeight() const { return m_imageHeightPtr; }
+    const quint32 *boxImage() const { return m_imageIdPtr; }
+    const qint32 *boxClass() const { return m_clsPtr; }
+    const float *boxXc() const { return m_xcPtr; }
+    const float *boxYc() const { return m_ycPtr; }
+    const float *boxW() const { return m_wPtr; }
+    const float *boxH() const { return m_hPtr; }
+
+private:
+    void bindOwned();
+    void countRange(const BoxQuery &query, int firstImage, int lastImage, int *counts) const;
+
+    int m_imageCount {0};
+    quint32 m_boxCount {0};
+    quint64 m_signature {0};
+    QStringList m_imagePaths;
+    QHash<QString, int> m_idByPath;
+
+    // dữ liệu tự quản lý (sau build)
+    std::vector<quint32> m_boxBegin;
+    std::vector<qint32> m_imageWidth, m_imageHeight;
+    std::vector<quint32> m_imageId;
+    std::vector<qint32> m_cls;
+    std::vector<float> m_xc, m_yc, m_w, m_h;
+    std::vector<float> m_wPx, m_hPx; // kích thước pixel tính sẵn để quét không cần gather
+
+    // view: trỏ vào vector ở trên hoặc vào vùng mmap
+    const quint32 *m_boxBeginPtr {nullptr};
+    const qint32 *m_imageWidthPtr {nullptr};
+    const qint32 *m_imageHeightPtr {nullptr};
+    const quint32 *m_imageIdPtr {nullptr};
+    const qint32 *m_clsPtr {nullptr};
+    const float *m_xcPtr {nullptr};
+    const float *m_ycPtr {nullptr};
+    const float *m_wPtr {nullptr};
+    const float *m_hPtr {nullptr};
+    const float *m_wPxPtr {nullptr};
+    const float *m_hPxPtr {nullptr};
+
+    QFile m_file;
+    uchar *m_map {nullptr};
+};
+
+#endif // BOXINDEX_H
@@ -0,0 +1,548 @@
+#include "datasetexporter.h"
+#include "augmentpolicy.h"
+#include "yololabel.h"
+#include <QtConcurrent/QtConcurrent>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QReadWriteLock>
+#include <QRegularExpression>
+#include <QSet>
+#include <QTextStream>
+#include <QDebug>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <limits>
+
+#if defined(Q_OS_UNIX)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#if defined(Q_OS_LINUX)
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
+#if defined(Q_OS_WIN)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+namespace {
+
+struct Group {
+    QString key;
+    QVector<int> members;        // chỉ số trong danh sách ảnh
+    QHash<int, int> classCounts; // tổng box theo class của cả nhóm
+    quint64 order {0};
+};
+
+struct ExportItem {
+    QString srcImage;
+    QString dstImage;
+    QString srcLabel;
+    QString dstLabel;
+};
+
+// Unsupported: lỗi của cả filesystem (khác thiết bị, không hỗ trợ clone/link), file khác cùng thư mục cũng sẽ lỗi;
+// FileError: lỗi riêng file này (đích đã có, quyền...), file sau vẫn nên thử
+enum class LinkResult { Ok, FileError, Unsupported };
+
+#if defined(Q_OS_UNIX)
+// Chỉ các lỗi này mới đúng cho mọi file của filesystem; EPERM, EACCES... là lỗi riêng từng file
+bool filesystemWide(int err)
+{
+    return err == EXDEV || err == ENOTSUP || err == EOPNOTSUPP || err == EMLINK;
+}
+#endif
+
+LinkResult reflinkFile(const QString &src, const QString &dst)
+{
+#if defined(Q_OS_LINUX) && defined(FICLONE)
+    QByteArray srcPath = QFile::encodeName(src);
+    QByteArray dstPath = QFile::encodeName(dst);
+
+    int in = ::open(srcPath.constData(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) return LinkResult::FileError;
+    struct stat st;
+    if (::fstat(in, &st) != 0) {
+        ::close(in);
+        return LinkResult::FileError;
+    }
+    int out = ::open(dstPath.constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, st.st_mode & 0777);
+    if (out < 0) {
+        ::close(in);
+        return LinkResult::FileError;
+    }
+    int err = ::ioctl(out, FICLONE, in) == 0 ? 0 : errno;
+    ::close(out);
+    ::close(in);
+    if (err == 0)
+        return LinkResult::Ok;
+    ::unlink(dstPath.constData());
+    return filesystemWide(err) ? LinkResult::Unsupported : LinkResult::FileError;
+#else
+    Q_UNUSED(src);
+    Q_UNUSED(dst);
+    return LinkResult::Unsupported;
+#endif
+}
+
+LinkResult hardlinkFile(const QString &src, const QString &dst)
+{
+#if defined(Q_OS_UNIX)
+    if (::link(QFile::encodeName(src).constData(), QFile::encodeName(dst).constData()) == 0)
+        return LinkResult::Ok;
+    return filesystemWide(errno) ? LinkResult::Unsupported : LinkResult::FileError;
+#elif defined(Q_OS_WIN)
+    if (CreateHardLinkW(reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(dst).utf16()),
+                        reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(src).utf16()), nullptr))
+        return LinkResult::Ok;
+    DWORD err = GetLastError();
+    return (err == ERROR_NOT_SAME_DEVICE || err == ERROR_INVALID_FUNCTION) ? LinkResult::Unsupported
+                                                                          : LinkResult::FileError;
+#else
+    Q_UNUSED(src);
+    Q_UNUSED(dst);
+    return LinkResult::Unsupported;
+#endif
+}
+
+// Thư mục nguồn nào đã biết là không reflink/hardlink được; dùng chung giữa các thread của 1 lần xuất.
+// Theo thư mục chứ không toàn cục: ảnh nằm ở mount khác chỉ làm các file cùng thư mục đó phải copy
+struct LinkSupport {
+    mutable QReadWriteLock lock;
+    QSet<QString> noReflink;
+    QSet<QString> noHardlink;
+
+    bool contains(const QSet<QString> &dirs, const QString &dir) const
+    {
+        QReadLocker locker(&lock);
+        return dirs.contains(dir);
+    }
+    void insert(QSet<QString> &dirs, const QString &dir)
+    {
+        QWriteLocker locker(&lock);
+        dirs.insert(dir);
+    }
+};
+
+DatasetExporter::Method placeFile(const QString &src, const QString &dst, DatasetExporter::LinkMode mode,
+                                  LinkSupport *support)
+{
+    using LinkMode = DatasetExporter::LinkMode;
+    using Method = DatasetExporter::Method;
+
+    if (QFileInfo::exists(dst))
+        QFile::remove(dst); // export lại vào cùng thư mục
+
+    // label luôn copy: link chung inode thì sửa label nguồn tại chỗ cũng sửa luôn bản đã export
+    if (src.endsWith(".txt", Qt::CaseInsensitive))
+        mode = LinkMode::Copy;
+
+    QString dir = src.left(src.lastIndexOf('/'));
+    if ((mode == LinkMode::Auto || mode == LinkMode::Reflink)
+        && !(support && support->contains(support->noReflink, dir))) {
+        LinkResult r = reflinkFile(src, dst);
+        if (r == LinkResult::Ok)
+            return Method::Reflink;
+        if (r == LinkResult::Unsupported && support)
+            support->insert(support->noReflink, dir);
+    }
+    if ((mode == LinkMode::Auto || mode == LinkMode::Hardlink)
+        && !(support && support->contains(support->noHardlink, dir))) {
+        LinkResult r = hardlinkFile(src, dst);
+        if (r == LinkResult::Ok)
+            return Method::Hardlink;
+        if (r == LinkResult::Unsupported && support)
+            support->insert(support->noHardlink, dir);
+    }
+    // khác filesystem / filesystem không hỗ trợ link -> copy thật
+    return QFile::copy(src, dst) ? Method::Copy : Method::Failed;
+}
+
+// Split có độ thiếu lớn nhất so với mục tiêu (tính cả nhóm sắp thêm)
+int mostLacking(const QVector<DatasetExporter::Split> &splits, const QVector<double> &current,
+                double assignedAfter)
+{
+    int best = 0;
+    double bestDeficit = -std::numeric_limits<double>::infinity();
+    for (int s = 0; s < splits.size(); ++s) {
+        double deficit = splits[s].ratio * assignedAfter - current[s];
+        if (deficit > bestDeficit) {
+            bestDeficit = deficit;
+            best = s;
+        }
+    }
+    return best;
+}
+
+}
+
+QStringList DatasetExporter::progressStages()
+{
+    return {"assign", "link"};
+}
+
+QVector<DatasetExporter::Split> DatasetExporter::parseSplits(const QString &spec, QString *error)
+{
+    static const QStringList names = {"train", "val", "test"};
+    QStringList parts = spec.split('/', Qt::SkipEmptyParts);
+    QVector<Split> splits;
+    double sum = 0.0;
+
+    if (parts.size() < 2 || parts.size() > names.size()) {
+        if (error) *error = QString("Expected 2 or 3 ratios like 80/10/10, got '%1'").arg(spec);
+        return {};
+    }
+    for (int i = 0; i < parts.size(); ++i) {
+        bool ok = false;
+        double v = parts[i].trimmed().toDouble(&ok);
+        if (!ok || v < 0.0) {
+            if (error) *error = QString("Invalid ratio '%1'").arg(parts[i].trimmed());
+            return {};
+        }
+        splits.push_back({names[i], v});
+        sum += v;
+    }
+    if (sum <= 0.0) {
+        if (error) *error = "Ratios sum to zero";
+        return {};
+    }
+    for (auto &s : splits)
+        s.ratio /= sum;
+    return splits;
+}
+
+QString DatasetExporter::groupKey(const QString &imagePath)
+{
+    static const QRegularExpression variantSuffix("(_FH|_FV|_R90|_R-90|_A\\d+|\\[(\\d+|L\\d+_x\\d+_y\\d+)\\])$");
+    QFileInfo info(imagePath);
+    QString base = info.completeBaseName();
+    // bỏ lần lượt từng hậu tố: "img_FH[2]" -> "img_FH" -> "img"
+    for (;;) {
+        QRegularExpressionMatch m = variantSuffix.match(base);
+        if (!m.hasMatch() || m.capturedStart() == 0) break;
+        base.truncate(m.capturedStart());
+    }
+    return info.absolutePath() + "/" + base;
+}
+
+void DatasetExporter::setOutputDir(const QString &dir) {
+    m_outputDir = dir;
+}
+
+void DatasetExporter::setSplits(const QVector<Split> &splits) {
+    m_splits = splits;
+}
+
+void DatasetExporter::setStrategy(Strategy strategy) {
+    m_strategy = strategy;
+}
+
+void DatasetExporter::setLinkMode(LinkMode mode) {
+    m_linkMode = mode;
+}
+
+void DatasetExporter::setSeed(quint64 seed) {
+    m_seed = seed;
+}
+
+void DatasetExporter::setClassNames(const QStringList &names) {
+    m_classNames = names;
+}
+
+void DatasetExporter::setProgress(ProgressChannel *channel) {
+    m_progress = channel;
+}
+
+QHash<QString, QString> DatasetExporter::assign(const QStringList &imagePaths, const DatasetIndex &index) const
+{
+    QHash<QString, QString> result;
+    if (m_splits.isEmpty()) return result;
+
+    // gom ảnh theo nhóm (ảnh gốc + mọi variant/tile của nó)
+    QHash<QString, int> groupByKey;
+    QVector<Group> groups;
+    for (int i = 0; i < imagePaths.size(); ++i) {
+        QString key = groupKey(imagePaths[i]);
+        auto it = groupByKey.find(key);
+        if (it == groupByKey.end()) {
+            it = groupByKey.insert(key, groups.size());
+            groups.push_back({key, {}, {}, AugmentPolicy::streamSeed(m_seed, key, 0)});
+        }
+        Group &g = groups[*it];
+        g.members.push_back(i);
+
+        int id = index.imageId(imagePaths[i]);
+        if (id < 0) continue;
+        const auto &counts = index.image(id).classCounts;
+        for (auto c = counts.constBegin(); c != counts.constEnd(); ++c)
+            g.classCounts[c.key()] += c.value();
+    }
+
+    // thứ tự xáo trộn theo seed, không phụ thuộc thứ tự file trong thư mục
+    std::sort(groups.begin(), groups.end(), [](const Group &a, const Group &b) {
+        return a.order != b.order ? a.order < b.order : a.key < b.key;
+    });
+
+    QVector<double> imagesIn(m_splits.size(), 0.0);
+    double assignedImages = 0.0;
+    QVector<int> splitOfGroup(groups.size(), 0);
+
+    if (m_strategy == Strategy::Stratified) {
+        QHash<int, double> classTotal;
+        for (const auto &g : groups)
+            for (auto c = g.classCounts.constBegin(); c != g.classCounts.constEnd(); ++c)
+                classTotal[c.key()] += c.value();
+
+        // class hiếm nhất của nhóm quyết định split (iterative stratification); nhóm chứa class hiếm xếp trước
+        auto rarest = [&classTotal](const Group &g) {
+            int best = -1;
+            for (auto c = g.classCounts.constBegin(); c != g.classCounts.constEnd(); ++c) {
+                if (best < 0 || classTotal[c.key()] < classTotal[best]
+                    || (classTotal[c.key()] == classTotal[best] && c.key() < best))
+                    best = c.key();
+            }
+            return best;
+        };
+
+        QVector<int> order(groups.size());
+        QVector<int> rarestClass(groups.size());
+        for (int g = 0; g < groups.size(); ++g) {
+            order[g] = g;
+            rarestClass[g] = rarest(groups[g]);
+        }
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+            bool la = rarestClass[a] >= 0, lb = rarestClass[b] >= 0;
+            if (la != lb) return la; // nhóm không có box xếp cuối
+            if (!la) return false;
+            return classTotal[rarestClass[a]] < classTotal[rarestClass[b]];
+        });
+
+        QHash<int, QVector<double>> have; // class -> số box đã vào từng split
+        for (int g : order) {
+            const Group &group = groups[g];
+            int s;
+            if (rarestClass[g] < 0) {
+                s = mostLacking(m_splits, imagesIn, assignedImages + group.members.size());
+            } else {
+                int c = rarestClass[g];
+                QVector<double> &h = have[c];
+                if (h.isEmpty()) h.fill(0.0, m_splits.size());
+                s = 0;
+                double bestDeficit = -std::numeric_limits<double>::infinity();
+                double bestImageDeficit = -std::numeric_limits<double>::infinity();
+                for (int k = 0; k < m_splits.size(); ++k) {
+                    double deficit = m_splits[k].ratio * classTotal[c] - h[k];
+                    double imageDeficit = m_splits[k].ratio * (assignedImages + group.members.size()) - imagesIn[k];
+                    if (deficit > bestDeficit || (deficit == bestDeficit && imageDeficit > bestImageDeficit)) {
+                        bestDeficit = deficit;
+                        bestImageDeficit = imageDeficit;
+                        s = k;
+                    }
+                }
+            }
+
+            for (auto c = group.classCounts.constBegin(); c != group.classCounts.constEnd(); ++c) {
+                QVector<double> &h = have[c.key()];
+                if (h.isEmpty()) h.fill(0.0, m_splits.size());
+                h[s] += c.value();
+            }
+            imagesIn[s] += group.members.size();
+            assignedImages += group.members.size();
+            splitOfGroup[g] = s;
+        }
+    } else {
+        for (int g = 0; g < groups.size(); ++g) {
+            int s = mostLacking(m_splits, imagesIn, assignedImages + groups[g].members.size());
+            imagesIn[s] += groups[g].members.size();
+            assignedImages += groups[g].members.size();
+            splitOfGroup[g] = s;
+        }
+    }
+
+    for (int g = 0; g < groups.size(); ++g)
+        for (int i : groups[g].members)
+            result.insert(imagePaths[i], m_splits[splitOfGroup[g]].name);
+    return result;
+}
+
+DatasetExporter::Method DatasetExporter::materialize(const QString &src, const QString &dst, LinkMode mode)
+{
+    return placeFile(src, dst, mode, nullptr);
+}
+
+DatasetExporter::Report DatasetExporter::run(const QStringList &imagePaths, const DatasetIndex &index)
+{
+    Report report;
+    QElapsedTimer timer;
+    timer.start();
+
+    if (m_outputDir.isEmpty() || m_splits.isEmpty()) {
+        qWarning() << "DatasetExporter: no output dir or splits";
+        return report;
+    }
+    if (m_progress)
+        m_progress->addTotal(imagePaths.size());
+
+    QHash<QString, QString> splitOf;
+    {
+        ProgressChannel::StageTimer t(m_progress, StageAssign);
+        splitOf = assign(imagePaths, index);
+    }
+
+    QDir out(m_outputDir);
+    for (const auto &s : m_splits) {
+        out.mkpath("images/" + s.name);
+        out.mkpath("labels/" + s.name);
+    }
+
+    QVector<ExportItem> items;
+    items.reserve(imagePaths.size());
+    QHash<QString, QStringList> exported; // split -> đường dẫn tương đối trong list file
+    QSet<QString> taken;
+    QSet<QString> groupKeys;
+    for (const QString &path : imagePaths) {
+        QFileInfo info(path);
+        QString split = splitOf.value(path);
+        QString relImage = QString("images/%1/%2").arg(split, info.fileName());
+        if (taken.contains(relImage)) {
+            qWarning() << "DatasetExporter: duplicate file name, skipped:" << path;
+            report.failed++;
+            if (m_progress) m_progress->itemFailed();
+            continue;
+        }
+        taken.insert(relImage);
+        groupKeys.insert(groupKey(path));
+
+        // label đã được index ghép sẵn (cùng thư mục hoặc labels/), khỏi stat lại từng file
+        QString srcLabel;
+        int id = index.imageId(path);
+        if (id >= 0) {
+            if (index.image(id).labelMTime >= 0)
+                srcLabel = index.image(id).labelPath;
+        } else if (QFileInfo::exists(YoloLabel::labelPathFor(path))) {
+            srcLabel = YoloLabel::labelPathFor(path);
+        }
+        items.push_back({path, out.filePath(relImage), srcLabel,
+                         out.filePath(QString("labels/%1/%2.txt").arg(split, info.completeBaseName()))});
+        exported[split] << "./" + relImage;
+        report.images[split]++;
+    }
+    report.groups = groupKeys.size();
+
+    // filesystem không hỗ trợ thì các file sau cùng thư mục bỏ qua syscall chắc chắn lỗi;
+    // lỗi riêng 1 file không làm các file khác phải copy
+    LinkSupport support;
+    std::atomic<int> reflinks {0}, hardlinks {0}, copies {0}, failed {0};
+    std::atomic<qint64> copiedBytes {0};
+
+    auto place = [&](const QString &src, const QString &dst) {
+        Method m = placeFile(src, dst, m_linkMode, &support);
+        switch (m) {
+        case Method::Reflink:
+            reflinks++;
+            break;
+        case Method::Hardlink:
+            hardlinks++;
+            break;
+        case Method::Copy:
+            copies++;
+            copiedBytes += QFileInfo(dst).size();
+            break;
+        case Method::Failed:
+            qWarning() << "DatasetExporter: cannot place" << src << "->" << dst;
+            break;
+        }
+        return m != Method::Failed;
+    };
+
+    QtConcurrent::blockingMap(items, [&](const ExportItem &item) {
+        ProgressChannel::StageTimer t(m_progress, StageLink);
+        bool ok = place(item.srcImage, item.dstImage);
+        if (ok && !item.srcLabel.isEmpty())
+            ok = place(item.srcLabel, item.dstLabel);
+
+        if (!ok) {
+            failed++;
+            if (m_progress) m_progress->itemFailed();
+        } else if (m_progress) {
+            m_progress->itemDone();
+        }
+    });
+
+    QList<int> classIds = index.classIds();
+    QString sourceDir = imagePaths.isEmpty() ? QString() : QFileInfo(imagePaths.first()).absolutePath();
+    writeListsAndYaml(exported, classIds, sourceDir);
+
+    report.reflinks = reflinks;
+    report.hardlinks = hardlinks;
+    report.copies = copies;
+    report.failed += failed;
+    report.copiedBytes = copiedBytes;
+    report.elapsedMs = timer.elapsed();
+
+    qDebug() << "DatasetExporter:" << items.size() << "images in" << report.groups << "groups ->" << m_outputDir
+             << "| reflink" << report.reflinks << "hardlink" << report.hardlinks << "copy" << report.copies
+             << "(" << report.copiedBytes << "bytes ) failed" << report.failed << "in" << report.elapsedMs << "ms";
+    for (const auto &s : m_splits)
+        qDebug() << "  " << s.name << ":" << report.images.value(s.name) << "images";
+    return report;
+}
+
+void DatasetExporter::writeListsAndYaml(const QHash<QString, QStringList> &exported, const QList<int> &classIds,
+                                        const QString &sourceDir) const
+{
+    QDir out(m_outputDir);
+
+    for (const auto &s : m_splits) {
+        QStringList lines = exported.value(s.name);
+        lines.sort();
+        QFile list(out.filePath(s.name + ".txt"));
+        if (!list.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate)) {
+            qWarning() << "DatasetExporter: cannot write" << list.fileName();
+            continue;
+        }
+        QTextStream ts(&list);
+        for (const QString &line : lines)
+            ts << line << "\n";
+    }
+
+    QStringList names = m_classNames;
+    if (names.isEmpty() && !sourceDir.isEmpty()) {
+        QFile classes(sourceDir + "/classes.txt");
+        if (classes.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            QTextStream in(&classes);
+            while (!in.atEnd()) {
+                QString line = in.readLine().trimmed();
+                if (!line.isEmpty()) names << line;
+            }
+        }
+    }
+
+    int nc = names.size();
+    for (int cls : classIds)
+        nc = std::max(nc, cls + 1);
+
+    QFile yaml(out.filePath("data.yaml"));
+    if (!yaml.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate)) {
+        qWarning() << "DatasetExporter: cannot write" << yaml.fileName();
+        return;
+    }
+    QTextStream ts(&yaml);
+    ts << "path: " << QDir(m_outputDir).absolutePath() << "\n";
+    for (const auto &s : m_splits)
+        ts << s.name << ": images/" << s.name << "\n";
+    ts << "\n";
+    ts << "nc: " << nc << "\n";
+    ts << "names:\n";
+    for (int cls = 0; cls < nc; ++cls) {
+        QString name = cls < names.size() ? names[cls] : QString::number(cls);
+        ts << "  " << cls << ": '" << QString(name).replace("'", "''") << "'\n";
+    }
+}
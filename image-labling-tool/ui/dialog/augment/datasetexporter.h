@@ -0,0 +1,86 @@
+#ifndef DATASETEXPORTER_H
+#define DATASETEXPORTER_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "datasetindex.h"
+#include "progresschannel.h"
+
+// Xuất dataset thành train/val/test theo layout YOLO (images/<split>, labels/<split>, data.yaml, <split>.txt).
+// File được link (reflink/hardlink) thay vì copy khi cùng filesystem -> gần như không tốn thêm dung lượng
+class DatasetExporter
+{
+public:
+    enum class Strategy {
+        Ratio,      // chia theo số ảnh
+        Stratified  // giữ tỉ lệ box của từng class ở mọi split
+    };
+
+    enum class LinkMode {
+        Auto,     // reflink -> hardlink -> copy
+        Reflink,  // reflink -> copy
+        Hardlink, // hardlink -> copy
+        Copy
+    };
+
+    enum class Method { Reflink, Hardlink, Copy, Failed };
+
+    struct Split {
+        QString name;
+        double ratio {0.0};
+    };
+
+    struct Report {
+        QHash<QString, int> images;  // split -> số ảnh
+        int groups {0};
+        int reflinks {0};
+        int hardlinks {0};
+        int copies {0};
+        int failed {0};
+        qint64 copiedBytes {0};      // chỉ tính file phải copy thật
+        qint64 elapsedMs {0};
+    };
+
+    enum ProgressStage { StageAssign, StageLink };
+    static QStringList progressStages();
+
+    DatasetExporter() = default;
+
+    // "80/10/10" -> train/val/test, "80/20" -> train/val; tỉ lệ được chuẩn hoá
+    static QVector<Split> parseSplits(const QString &spec, QString *error = nullptr);
+
+    // Tên nhóm: bỏ hết hậu tố augment (_FH, _FV, _R90, _R-90, _A<n>, [n], [L<k>_x<X>_y<Y>]) -> variant đi cùng ảnh gốc
+    static QString groupKey(const QString &imagePath);
+
+    void setOutputDir(const QString &dir);
+    void setSplits(const QVector<Split> &splits);
+    void setStrategy(Strategy strategy);
+    void setLinkMode(LinkMode mode);
+    void setSeed(quint64 seed);
+    void setClassNames(const QStringList &names); // rỗng -> đọc classes.txt cạnh ảnh, không có thì dùng số
+    void setProgress(ProgressChannel *channel);   // mỗi ảnh là 1 item
+
+    // Ảnh -> tên split; class lấy từ index (ảnh không có trong index coi như không có box)
+    QHash<QString, QString> assign(const QStringList &imagePaths, const DatasetIndex &index) const;
+
+    Report run(const QStringList &imagePaths, const DatasetIndex &index);
+
+    // Tạo dst trỏ tới nội dung của src; tự lùi về cách rẻ kế tiếp khi filesystem không hỗ trợ
+    static Method materialize(const QString &src, const QString &dst, LinkMode mode);
+
+private:
+    void writeListsAndYaml(const QHash<QString, QStringList> &exported, const QList<int> &classIds,
+                           const QString &sourceDir) const;
+
+    QString m_outputDir;
+    QVector<Split> m_splits {{"train", 0.8}, {"val", 0.1}, {"test", 0.1}};
+    Strategy m_strategy {Strategy::Ratio};
+    LinkMode m_linkMode {LinkMode::Auto};
+    quint64 m_seed {0};
+    QStringList m_classNames;
+    ProgressChannel *m_progress {nullptr};
+};
+
+#endif // DATASETEXPORTER_H
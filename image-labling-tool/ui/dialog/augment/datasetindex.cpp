@@ -0,0 +1,201 @@
+#include "datasetindex.h"
+#include "yololabel.h"
+#include <QtConcurrent/QtConcurrent>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QImageReader>
+#include <QSet>
+#include <QDebug>
+#include <algorithm>
+
+namespace {
+
+qint64 labelMTime(const QString &labelPath)
+{
+    if (labelPath.isEmpty()) return -1;
+    QFileInfo info(labelPath);
+    return info.exists() ? info.lastModified().toMSecsSinceEpoch() : -1;
+}
+
+// rỗng -> biết chắc là không có label, khỏi stat
+QString labelFor(const QString &imagePath, const QHash<QString, QString> *labelPaths)
+{
+    return labelPaths ? labelPaths->value(imagePath) : YoloLabel::labelPathFor(imagePath);
+}
+
+}
+
+DatasetIndex::ImageEntry DatasetIndex::scanImage(const QString &imagePath, const QString &labelPath)
+{
+    ImageEntry entry;
+    entry.imagePath = imagePath;
+    entry.labelPath = labelPath.isEmpty() ? YoloLabel::labelPathFor(imagePath) : labelPath;
+    entry.labelMTime = labelMTime(labelPath);
+
+    if (entry.labelMTime >= 0) {
+        entry.boxes = YoloLabel::read(entry.labelPath);
+        for (const auto &b : entry.boxes)
+            entry.classCounts[b.cls]++;
+        entry.boxCount = entry.boxes.size();
+    }
+    if (entry.boxCount > 0)
+        entry.imageSize = QImageReader(imagePath).size(); // không decode
+    return entry;
+}
+
+void DatasetIndex::clear()
+{
+    m_images.clear();
+    m_idByPath.clear();
+    m_classes.clear();
+}
+
+void DatasetIndex::build(const QStringList &imagePaths, const QHash<QString, QString> *labelPaths)
+{
+    clear();
+
+    // parse label song song, ghép vào index tuần tự
+    QVector<ImageEntry> entries =
+        QtConcurrent::blockingMapped<QVector<ImageEntry>>(imagePaths, [labelPaths](const QString &path) {
+            return scanImage(path, labelFor(path, labelPaths));
+        });
+
+    m_images.reserve(entries.size());
+    for (const auto &entry : entries) {
+        int id = m_images.size();
+        m_images.push_back(ImageEntry());
+        insertEntry(id, entry);
+    }
+
+    qDebug() << "DatasetIndex: indexed" << m_images.size() << "images," << m_classes.size() << "classes";
+}
+
+int DatasetIndex::refresh(const QStringList &imagePaths, const QHash<QString, QString> *labelPaths)
+{
+    QSet<QString> current(imagePaths.begin(), imagePaths.end());
+
+    // ảnh đã bị xoá khỏi thư mục
+    int updated = 0;
+    for (int id = 0; id < m_images.size(); ++id) {
+        if (!m_images[id].removed && !current.contains(m_images[id].imagePath)) {
+            eraseEntry(id);
+            updated++;
+        }
+    }
+
+    // chỉ stat song song, chỉ parse lại label có mtime khác
+    QStringList changed;
+    QVector<qint64> mtimes = QtConcurrent::blockingMapped<QVector<qint64>>(imagePaths, [labelPaths](const QString &path) {
+        return labelMTime(labelFor(path, labelPaths));
+    });
+    for (int i = 0; i < imagePaths.size(); ++i) {
+        int id = imageId(imagePaths[i]);
+        if (id < 0 || m_images[id].labelMTime != mtimes[i])
+            changed << imagePaths[i];
+    }
+
+    QVector<ImageEntry> entries =
+        QtConcurrent::blockingMapped<QVector<ImageEntry>>(changed, [labelPaths](const QString &path) {
+            return scanImage(path, labelFor(path, labelPaths));
+        });
+    for (const auto &entry : entries) {
+        int id = imageId(entry.imagePath);
+        if (id < 0) {
+            id = m_images.size();
+            m_images.push_back(ImageEntry());
+        } else {
+            eraseEntry(id);
+        }
+        insertEntry(id, entry);
+        updated++;
+    }
+
+    return updated;
+}
+
+void DatasetIndex::updateImage(const QString &imagePath)
+{
+    int id = imageId(imagePath);
+    QString labelPath = id >= 0 ? m_images[id].labelPath : YoloLabel::labelPathFor(imagePath);
+    if (id < 0) {
+        id = m_images.size();
+        m_images.push_back(ImageEntry());
+    } else {
+        eraseEntry(id);
+    }
+    insertEntry(id, scanImage(imagePath, labelPath));
+}
+
+void DatasetIndex::removeImage(const QString &imagePath)
+{
+    int id = imageId(imagePath);
+    if (id >= 0)
+        eraseEntry(id);
+}
+
+void DatasetIndex::insertEntry(int id, const ImageEntry &entry)
+{
+    m_images[id] = entry;
+    m_idByPath.insert(entry.imagePath, id);
+
+    for (auto it = entry.classCounts.constBegin(); it != entry.classCounts.constEnd(); ++it) {
+        ClassEntry &c = m_classes[it.key()];
+        c.images.insert(id, it.value());
+        c.boxCount += it.value();
+    }
+}
+
+void DatasetIndex::eraseEntry(int id)
+{
+    ImageEntry &entry = m_images[id];
+    if (entry.removed) return;
+
+    for (auto it = entry.classCounts.constBegin(); it != entry.classCounts.constEnd(); ++it) {
+        auto cit = m_classes.find(it.key());
+        if (cit == m_classes.end()) continue;
+        cit->images.remove(id);
+        cit->boxCount -= it.value();
+        if (cit->images.isEmpty())
+            m_classes.erase(cit);
+    }
+
+    m_idByPath.remove(entry.imagePath);
+    entry.classCounts.clear();
+    entry.boxCount = 0;
+    entry.boxes.clear();
+    entry.removed = true;
+}
+
+int DatasetIndex::boxCount(int cls) const
+{
+    auto it = m_classes.constFind(cls);
+    return it == m_classes.constEnd() ? 0 : it->boxCount;
+}
+
+int DatasetIndex::imageCount(int cls) const
+{
+    auto it = m_classes.constFind(cls);
+    return it == m_classes.constEnd() ? 0 : it->images.size();
+}
+
+QVector<int> DatasetIndex::imagesWithClass(int cls) const
+{
+    auto it = m_classes.constFind(cls);
+    if (it == m_classes.constEnd()) return {};
+
+    QVector<int> ids = it->images.keys();
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+bool DatasetIndex::hasLabel(const QString &imagePath) const
+{
+    int id = imageId(imagePath);
+    return id >= 0 && m_images[id].boxCount > 0;
+}
+
+QString DatasetIndex::labelPath(const QString &imagePath) const
+{
+    int id = imageId(imagePath);
+    return id >= 0 ? m_images[id].labelPath : YoloLabel::labelPathFor(imagePath);
+}
@@ -0,0 +1,67 @@
+#ifndef DATASETINDEX_H
+#define DATASETINDEX_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QMap>
+#include <QList>
+#include <QSize>
+#include "yololabel.h"
+
+// Chỉ mục class -> (ảnh, số box); dựng song song từ file label, cập nhật dần khi label đổi
+class DatasetIndex
+{
+public:
+    struct ImageEntry {
+        QString imagePath;
+        QString labelPath;
+        qint64 labelMTime {-1};     // -1: không có file label
+        QHash<int, int> classCounts; // class id -> số box
+        int boxCount {0};
+        QVector<BBox> boxes;         // giữ lại để BoxIndex dựng từ index, không đọc lại label
+        QSize imageSize;             // chỉ đọc header, chỉ với ảnh có box
+        bool removed {false};
+    };
+
+    struct ClassEntry {
+        QHash<int, int> images; // image id -> số box của class
+        int boxCount {0};
+    };
+
+    DatasetIndex() = default;
+
+    // labelPaths: ảnh -> label đã ghép sẵn (vd. từ DatasetScanner), ảnh không có trong map coi như chưa có label;
+    // null -> label .txt cùng thư mục với ảnh
+    void build(const QStringList &imagePaths, const QHash<QString, QString> *labelPaths = nullptr);
+    void clear();
+
+    // Đọc lại các label có mtime thay đổi, thêm ảnh mới, bỏ ảnh đã mất; trả về số ảnh được cập nhật
+    int refresh(const QStringList &imagePaths, const QHash<QString, QString> *labelPaths = nullptr);
+    void updateImage(const QString &imagePath);
+    void removeImage(const QString &imagePath);
+
+    int imageId(const QString &imagePath) const { return m_idByPath.value(imagePath, -1); }
+    const ImageEntry &image(int id) const { return m_images[id]; }
+    int imageSlots() const { return m_images.size(); }
+
+    QList<int> classIds() const { return m_classes.keys(); }
+    int boxCount(int cls) const;
+    int imageCount(int cls) const;
+    QVector<int> imagesWithClass(int cls) const;
+    bool hasLabel(const QString &imagePath) const;
+    // Label của ảnh trong index; ảnh chưa có trong index -> .txt cùng thư mục
+    QString labelPath(const QString &imagePath) const;
+
+private:
+    static ImageEntry scanImage(const QString &imagePath, const QString &labelPath);
+    void insertEntry(int id, const ImageEntry &entry);
+    void eraseEntry(int id);
+
+    QVector<ImageEntry> m_images;
+    QHash<QString, int> m_idByPath;
+    QMap<int, ClassEntry> m_classes;
+};
+
+#endif // DATASETINDEX_H
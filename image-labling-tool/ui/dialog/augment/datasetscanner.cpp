@@ -0,0 +1,352 @@
+#include "datasetscanner.h"
+#include "yololabel.h"
+#include <QtConcurrent/QtConcurrent>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMultiHash>
+#include <QSet>
+#include <QDebug>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+#ifdef Q_OS_LINUX
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#ifdef Q_OS_LINUX
+// 1 MiB mỗi lần gọi getdents64: thư mục 100k file chỉ tốn vài syscall (readdir của glibc đọc 32 KiB/lần),
+// quan trọng trên NFS/SMB nơi mỗi round trip đắt
+const int kDirBufferSize = 1 << 20;
+#else
+const int kDirChunkSize = 4096;
+#endif
+
+// ít entry thiếu d_type thì stat tuần tự cho nhanh, nhiều thì stat song song
+const int kParallelStatThreshold = 64;
+
+struct DirTask {
+    QString dir;
+    QString labelDir;      // labels/<...> tương ứng, đọc trước thư mục ảnh
+    bool labelDirInLevel;  // labels/<...> cũng thuộc mức đang quét -> task này thay luôn task của nó
+};
+
+struct DirResult {
+    QStringList subdirs;
+    DatasetScanner::Stats stats;
+};
+
+struct ScanContext {
+    QSet<QString> imageSuffixes;
+    int batchSize {512};
+    bool descend {false};
+    std::function<void(const QVector<DatasetScanner::Entry> &)> emitBatch;
+    const std::atomic<bool> *stopped {nullptr};
+};
+
+DirResult scanDirectory(const DirTask &task, const ScanContext &ctx)
+{
+    DirResult result;
+
+    // label ở labels/<...> biết trước -> ảnh có label ở đó được đẩy ngay khi đọc tới
+    QHash<QString, QString> mirroredLabels;
+    if (!task.labelDir.isEmpty() && (task.labelDirInLevel || QFileInfo(task.labelDir).isDir())) {
+        int statCalls = 0;
+        for (const auto &e : DatasetScanner::listDirectory(task.labelDir, &statCalls)) {
+            QString path = task.labelDir + "/" + e.name;
+            if (e.isDir) {
+                if (task.labelDirInLevel && ctx.descend && !e.name.startsWith('.'))
+                    result.subdirs << path;
+                continue;
+            }
+            if (!e.name.endsWith(".txt", Qt::CaseInsensitive)) continue;
+            QString key = DatasetScanner::mirroredImageKey(path);
+            if (!key.isEmpty())
+                mirroredLabels.insert(key, path);
+            result.stats.labels++;
+        }
+        result.stats.statCalls += statCalls;
+        if (task.labelDirInLevel)
+            result.stats.directories++;
+    }
+
+    // ghép bằng hash map: key = thư mục ảnh + tên không đuôi
+    QHash<QString, QString> siblingLabels;
+    QMultiHash<QString, QString> pending; // ảnh chưa thấy label: label cùng thư mục có thể nằm ở chunk sau
+    QVector<DatasetScanner::Entry> batch;
+    auto push = [&](const QString &imagePath, const QString &labelPath) {
+        batch.push_back({imagePath, labelPath});
+        result.stats.images++;
+        if (!labelPath.isEmpty())
+            result.stats.paired++;
+        if (batch.size() >= ctx.batchSize) {
+            ctx.emitBatch(batch);
+            batch.clear();
+        }
+    };
+
+    int statCalls = 0;
+    DatasetScanner::listDirectoryChunks(task.dir, [&](const QVector<DatasetScanner::DirEntry> &chunk) {
+        for (const auto &e : chunk) {
+            QString path = task.dir + "/" + e.name;
+            if (e.isDir) {
+                if (ctx.descend && !e.name.startsWith('.'))
+                    result.subdirs << path;
+                continue;
+            }
+
+            int dot = e.name.lastIndexOf('.');
+            if (dot <= 0) continue;
+            QString key = task.dir + "/" + e.name.left(dot);
+            QString suffix = e.name.mid(dot + 1).toLower();
+
+            if (suffix == "txt") {
+                result.stats.labels++;
+                siblingLabels.insert(key, path);
+                QStringList images = pending.values(key);
+                std::sort(images.begin(), images.end());
+                for (const QString &image : images)
+                    push(image, path);
+                pending.remove(key);
+                continue;
+            }
+            if (!ctx.imageSuffixes.contains(suffix)) continue;
+
+            // label cùng thư mục đã gặp thì ưu tiên, không thì labels/<...>
+            QString label = siblingLabels.value(key);
+            if (label.isEmpty())
+                label = mirroredLabels.value(key);
+            if (label.isEmpty())
+                pending.insert(key, path);
+            else
+                push(path, label);
+        }
+        // phần lẻ đẩy ngay sau mỗi chunk: bảng có ảnh khi thư mục lớn còn đang đọc
+        ctx.emitBatch(batch);
+        batch.clear();
+        return !*ctx.stopped;
+    }, &statCalls);
+
+    // đọc hết thư mục mà vẫn chưa thấy label -> ảnh chưa có label
+    QStringList unlabelled = pending.values();
+    std::sort(unlabelled.begin(), unlabelled.end());
+    for (const QString &image : unlabelled)
+        push(image, QString());
+    ctx.emitBatch(batch);
+
+    result.stats.directories++;
+    result.stats.statCalls += statCalls;
+    return result;
+}
+
+}
+
+void DatasetScanner::setMaxDepth(int depth)
+{
+    m_maxDepth = depth;
+}
+
+void DatasetScanner::setImageSuffixes(const QStringList &suffixes)
+{
+    m_imageSuffixes.clear();
+    for (const QString &s : suffixes)
+        m_imageSuffixes << s.toLower();
+}
+
+void DatasetScanner::setBatchSize(int n)
+{
+    m_batchSize = std::max(1, n);
+}
+
+bool DatasetScanner::listDirectoryChunks(const QString &dir, const ChunkFn &onChunk, int *statCalls)
+{
+    int stats = 0;
+
+#ifdef Q_OS_LINUX
+    int fd = ::open(QFile::encodeName(dir).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        qWarning() << "DatasetScanner: cannot open" << dir;
+        if (statCalls) *statCalls = 0;
+        return false;
+    }
+
+    QByteArray buffer(kDirBufferSize, Qt::Uninitialized);
+    for (;;) {
+        long n = syscall(SYS_getdents64, fd, buffer.data(), buffer.size());
+        if (n <= 0) break; // 0: hết, < 0: lỗi
+
+        QVector<DirEntry> entries;
+        QVector<int> unknown;   // DT_UNKNOWN / DT_LNK -> phải stat mới biết là file hay thư mục
+        for (long off = 0; off < n;) {
+            const auto *d = reinterpret_cast<const dirent64 *>(buffer.constData() + off);
+            off += d->d_reclen;
+
+            const char *name = d->d_name;
+            if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+                continue;
+            if (d->d_type != DT_REG && d->d_type != DT_DIR && d->d_type != DT_UNKNOWN && d->d_type != DT_LNK)
+                continue; // fifo, socket, device
+
+            if (d->d_type == DT_UNKNOWN || d->d_type == DT_LNK)
+                unknown << entries.size();
+            entries.push_back({QFile::decodeName(name), d->d_type == DT_DIR});
+        }
+
+        if (!unknown.isEmpty()) {
+            // symlink tới thư mục bị bỏ qua để đệ quy không đi vòng; symlink tới file vẫn giữ
+            QVector<char> keep(entries.size(), 1);
+            DirEntry *data = entries.data();
+            char *keepData = keep.data();
+            auto resolve = [fd, data, keepData](int i) {
+                QByteArray name = QFile::encodeName(data[i].name);
+                struct stat st;
+                if (fstatat(fd, name.constData(), &st, AT_SYMLINK_NOFOLLOW) != 0) {
+                    keepData[i] = 0;
+                    return;
+                }
+                if (S_ISLNK(st.st_mode)) {
+                    keepData[i] = fstatat(fd, name.constData(), &st, 0) == 0 && S_ISREG(st.st_mode);
+                    return;
+                }
+                data[i].isDir = S_ISDIR(st.st_mode);
+                keepData[i] = S_ISDIR(st.st_mode) || S_ISREG(st.st_mode);
+            };
+            if (unknown.size() >= kParallelStatThreshold)
+                QtConcurrent::blockingMap(unknown, resolve);
+            else
+                std::for_each(unknown.begin(), unknown.end(), resolve);
+            stats += unknown.size();
+
+            int out = 0;
+            for (int i = 0; i < entries.size(); ++i) {
+                if (keep[i])
+                    entries[out++] = entries[i];
+            }
+            entries.resize(out);
+        }
+
+        if (!entries.isEmpty() && !onChunk(entries))
+            break;
+    }
+    ::close(fd);
+#else
+    // API liệt kê của Windows/macOS trả kèm thuộc tính -> QFileInfo không stat thêm
+    QDirIterator it(dir, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot);
+    QVector<DirEntry> entries;
+    while (it.hasNext()) {
+        it.next();
+        QFileInfo info = it.fileInfo();
+        if (info.isSymLink() && info.isDir()) continue;
+        entries.push_back({info.fileName(), info.isDir()});
+        if (entries.size() >= kDirChunkSize) {
+            if (!onChunk(entries)) break;
+            entries.clear();
+        }
+    }
+    if (!entries.isEmpty())
+        onChunk(entries);
+#endif
+
+    if (statCalls) *statCalls = stats;
+    return true;
+}
+
+QVector<DatasetScanner::DirEntry> DatasetScanner::listDirectory(const QString &dir, int *statCalls)
+{
+    QVector<DirEntry> entries;
+    listDirectoryChunks(dir, [&entries](const QVector<DirEntry> &chunk) {
+        entries += chunk;
+        return true;
+    }, statCalls);
+
+    std::sort(entries.begin(), entries.end(), [](const DirEntry &a, const DirEntry &b) {
+        return a.name < b.name;
+    });
+    return entries;
+}
+
+QString DatasetScanner::mirroredImageKey(const QString &labelPath)
+{
+    int i = labelPath.lastIndexOf("/labels/");
+    if (i < 0) return QString();
+
+    QString key = labelPath;
+    key.replace(i, 8, "/images/");
+    int dot = key.lastIndexOf('.');
+    if (dot > key.lastIndexOf('/'))
+        key.truncate(dot);
+    return key;
+}
+
+void DatasetScanner::scan(const QString &root, const BatchFn &onBatch)
+{
+    QElapsedTimer timer;
+    timer.start();
+    m_stats = Stats();
+
+    // các thư mục được đọc song song nhưng onBatch luôn được gọi tuần tự
+    std::atomic<bool> stopped {false};
+    std::mutex batchMutex;
+    ScanContext ctx;
+    ctx.imageSuffixes = QSet<QString>(m_imageSuffixes.begin(), m_imageSuffixes.end());
+    ctx.batchSize = m_batchSize;
+    ctx.stopped = &stopped;
+    ctx.emitBatch = [&](const QVector<Entry> &batch) {
+        if (batch.isEmpty() || stopped) return;
+        std::lock_guard<std::mutex> lock(batchMutex);
+        if (!stopped && onBatch && !onBatch(batch))
+            stopped = true;
+    };
+
+    // duyệt theo từng mức độ sâu, các thư mục cùng mức được đọc song song
+    QStringList level {QDir::cleanPath(QDir(root).absolutePath())};
+    for (int depth = 0; !level.isEmpty() && !stopped; ++depth) {
+        ctx.descend = m_maxDepth < 0 || depth < m_maxDepth;
+
+        // images/<x> và labels/<x> luôn cùng mức: labels/<x> được đọc trong task của images/<x>;
+        // labels nằm ngoài root (root chính là .../images) thì task đọc thêm, không đệ quy vào đó
+        QSet<QString> listed(level.begin(), level.end());
+        QSet<QString> owned;
+        for (const QString &dir : level) {
+            QString labelDir = YoloLabel::mirroredLabelDir(dir);
+            if (!labelDir.isEmpty() && listed.contains(labelDir))
+                owned.insert(labelDir);
+        }
+        QVector<DirTask> tasks;
+        for (const QString &dir : level) {
+            if (owned.contains(dir)) continue;
+            QString labelDir = YoloLabel::mirroredLabelDir(dir);
+            tasks.push_back({dir, labelDir, owned.contains(labelDir)});
+        }
+
+        QVector<DirResult> results = QtConcurrent::blockingMapped<QVector<DirResult>>(
+            tasks, [&ctx](const DirTask &task) { return scanDirectory(task, ctx); });
+
+        QStringList next;
+        for (const auto &r : results) {
+            next += r.subdirs;
+            m_stats.directories += r.stats.directories;
+            m_stats.images += r.stats.images;
+            m_stats.labels += r.stats.labels;
+            m_stats.paired += r.stats.paired;
+            m_stats.statCalls += r.stats.statCalls;
+        }
+        std::sort(next.begin(), next.end());
+        level = next;
+    }
+
+    m_stats.elapsedMs = timer.elapsed();
+    qDebug() << "DatasetScanner:" << m_stats.images << "images," << m_stats.paired << "with labels,"
+             << m_stats.directories << "directories," << m_stats.statCalls << "stat calls in"
+             << m_stats.elapsedMs << "ms" << (stopped ? "(stopped)" : "");
+}
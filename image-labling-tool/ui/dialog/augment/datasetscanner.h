@@ -0,0 +1,66 @@
+#ifndef DATASETSCANNER_H
+#define DATASETSCANNER_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <functional>
+
+// Quét thư mục dataset cho bảng ảnh: đọc entry theo lô lớn (getdents64 trên Linux), chỉ stat khi
+// filesystem không trả về loại entry, đệ quy theo độ sâu giới hạn, ghép ảnh với label bằng hash map
+// (label cùng thư mục, hoặc layout YOLO images/<...> <-> labels/<...>)
+class DatasetScanner
+{
+public:
+    struct Entry {
+        QString imagePath;
+        QString labelPath; // rỗng -> không có label
+    };
+
+    struct DirEntry {
+        QString name;
+        bool isDir {false};
+    };
+
+    struct Stats {
+        int directories {0};
+        int images {0};
+        int labels {0};
+        int paired {0};
+        int statCalls {0};   // số entry phải stat vì không có d_type
+        qint64 elapsedMs {0};
+    };
+
+    // Trả về false để dừng quét (vd. người dùng đã chọn thư mục khác); luôn được gọi tuần tự
+    using BatchFn = std::function<bool(const QVector<Entry> &batch)>;
+    // 1 lần đọc thư mục (1 buffer getdents), chưa sắp xếp; trả về false để dừng đọc
+    using ChunkFn = std::function<bool(const QVector<DirEntry> &chunk)>;
+
+    DatasetScanner() = default;
+
+    void setMaxDepth(int depth);    // 0 -> chỉ thư mục gốc, < 0 -> không giới hạn
+    void setImageSuffixes(const QStringList &suffixes);
+    void setBatchSize(int n);       // số ảnh mỗi lần gọi BatchFn
+
+    // Ảnh được đẩy ra ngay trong lúc thư mục còn đang đọc, không giữ lại danh sách kết quả.
+    // Thư mục nông trước; trong 1 thư mục theo thứ tự đọc, ảnh chưa thấy label đợi tới cuối thư mục
+    // (label cùng thư mục có thể tới sau); ảnh có label ở labels/<...> được đẩy ngay
+    void scan(const QString &root, const BatchFn &onBatch);
+    const Stats &stats() const { return m_stats; }
+
+    // Các entry của 1 thư mục (bỏ "." và ".."), theo tên; symlink được stat để biết là file hay thư mục
+    static QVector<DirEntry> listDirectory(const QString &dir, int *statCalls = nullptr);
+    // Như trên nhưng trả dần từng chunk trong lúc đọc; false -> không mở được thư mục
+    static bool listDirectoryChunks(const QString &dir, const ChunkFn &onChunk, int *statCalls = nullptr);
+
+    // ".../labels/<...>/a.txt" -> ".../images/<...>/a" (key của ảnh tương ứng, không có đuôi); không phải layout đó -> rỗng
+    static QString mirroredImageKey(const QString &labelPath);
+
+private:
+    int m_maxDepth {0};
+    QStringList m_imageSuffixes {"jpg", "jpeg", "png", "bmp", "webp"};
+    int m_batchSize {512};
+    Stats m_stats;
+};
+
+#endif // DATASETSCANNER_H
@@ -0,0 +1,138 @@
+#include "dnndetector.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+DnnDetector::DnnDetector(const QString &modelPath, const QSize &inputSize)
+    : m_inputSize(std::max(32, inputSize.width()), std::max(32, inputSize.height()))
+{
+    try {
+        m_net = cv::dnn::readNet(modelPath.toStdString());
+    } catch (const cv::Exception &ex) {
+        m_error = QString::fromStdString(ex.what());
+    }
+    if (m_net.empty() && m_error.isEmpty())
+        m_error = QString("Cannot load model: %1").arg(modelPath);
+}
+
+cv::Mat DnnDetector::letterbox(const cv::Mat &img, const cv::Size &size, Letterbox *lb)
+{
+    lb->scale = std::min(double(size.width) / img.cols, double(size.height) / img.rows);
+    int w = std::max(1, int(std::lround(img.cols * lb->scale)));
+    int h = std::max(1, int(std::lround(img.rows * lb->scale)));
+    lb->padX = (size.width - w) / 2;
+    lb->padY = (size.height - h) / 2;
+
+    cv::Mat out(size, img.type(), cv::Scalar::all(114));
+    cv::Mat roi = out(cv::Rect(lb->padX, lb->padY, w, h));
+    cv::resize(img, roi, roi.size(), 0, 0, cv::INTER_LINEAR);
+    return out;
+}
+
+QVector<QVector<Detection>> DnnDetector::detectBatch(const std::vector<cv::Mat> &images, double minimumScore)
+{
+    QVector<QVector<Detection>> results;
+    if (m_net.empty() || images.empty()) {
+        results.resize(int(images.size()));
+        return results;
+    }
+
+    std::vector<cv::Mat> inputs;
+    std::vector<Letterbox> boxes(images.size());
+    std::vector<cv::Size> tileSizes;
+    for (size_t i = 0; i < images.size(); ++i) {
+        inputs.push_back(letterbox(images[i], m_inputSize, &boxes[i]));
+        tileSizes.push_back(images[i].size());
+    }
+
+    if (m_batched && inputs.size() > 1) {
+        try {
+            forward(inputs, boxes, tileSizes, minimumScore, &results);
+            return results;
+        } catch (const cv::Exception &ex) {
+            // model xuất với batch cố định = 1 -> chạy từng tile từ giờ
+            qWarning() << "Model does not take batches, running tiles one by one:" << ex.what();
+            m_batched = false;
+            results.clear();
+        }
+    }
+
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        try {
+            forward({inputs[i]}, {boxes[i]}, {tileSizes[i]}, minimumScore, &results);
+        } catch (const cv::Exception &ex) {
+            qWarning() << "Model inference failed:" << ex.what();
+            results.push_back({});
+        }
+    }
+    return results;
+}
+
+void DnnDetector::forward(const std::vector<cv::Mat> &inputs, const std::vector<Letterbox> &boxes,
+                          const std::vector<cv::Size> &tileSizes, double minimumScore,
+                          QVector<QVector<Detection>> *results)
+{
+    cv::Mat blob = cv::dnn::blobFromImages(inputs, 1.0 / 255.0, m_inputSize, cv::Scalar(), true, false);
+    m_net.setInput(blob);
+    cv::Mat out = m_net.forward();
+
+    // [N, a, b] hoặc [a, b] khi model bỏ chiều batch
+    int n = out.dims == 3 ? out.size[0] : 1;
+    int a = out.dims == 3 ? out.size[1] : out.size[0];
+    int b = out.dims == 3 ? out.size[2] : out.size[1];
+    if (n != int(inputs.size()))
+        CV_Error(cv::Error::StsUnmatchedSizes, "model output batch does not match input batch");
+
+    QVector<QVector<Detection>> batch;
+    for (int i = 0; i < n; ++i) {
+        cv::Mat rows(a, b, CV_32F, out.ptr<float>(i));
+        // v8: mỗi cột là 1 anchor -> chuyển thành mỗi dòng 1 anchor, không có objectness
+        bool objectness = a > b;
+        batch.push_back(decode(objectness ? rows : cv::Mat(rows.t()), objectness, boxes[i], tileSizes[i], minimumScore));
+    }
+    *results += batch;
+}
+
+QVector<Detection> DnnDetector::decode(const cv::Mat &rows, bool objectness, const Letterbox &lb,
+                                       const cv::Size &tileSize, double minimumScore) const
+{
+    int classOffset = objectness ? 5 : 4;
+    int classes = rows.cols - classOffset;
+    if (classes <= 0) return {};
+
+    std::vector<cv::Rect2d> found;
+    std::vector<float> scores;
+    std::vector<int> ids;
+    for (int r = 0; r < rows.rows; ++r) {
+        const float *p = rows.ptr<float>(r);
+        const float *best = std::max_element(p + classOffset, p + classOffset + classes);
+        float score = objectness ? *best * p[4] : *best;
+        if (score < minimumScore) continue;
+
+        // cx, cy, w, h theo pixel input -> bỏ padding, chia scale -> pixel tile
+        double x = (p[0] - p[2] / 2.0 - lb.padX) / lb.scale;
+        double y = (p[1] - p[3] / 2.0 - lb.padY) / lb.scale;
+        found.emplace_back(x, y, p[2] / lb.scale, p[3] / lb.scale);
+        scores.push_back(score);
+        ids.push_back(int(best - (p + classOffset)));
+    }
+
+    // NMS 1 lần cho mọi class: dời box của mỗi class ra 1 vùng riêng để không đè nhau
+    double offset = std::max(tileSize.width, tileSize.height) + 1.0;
+    std::vector<cv::Rect2d> shifted = found;
+    for (size_t i = 0; i < shifted.size(); ++i) {
+        shifted[i].x += offset * ids[i];
+        shifted[i].y += offset * ids[i];
+    }
+    std::vector<int> keep;
+    cv::dnn::NMSBoxes(shifted, scores, float(minimumScore), float(m_nmsThreshold), keep);
+
+    cv::Rect2d tile(0.0, 0.0, tileSize.width, tileSize.height);
+    QVector<Detection> detections;
+    for (int i : keep) {
+        cv::Rect2d box = found[i] & tile;
+        if (box.area() <= 0.0) continue;
+        detections.push_back({ids[i], scores[i], cv::Rect2f(float(box.x), float(box.y), float(box.width), float(box.height))});
+    }
+    return detections;
+}
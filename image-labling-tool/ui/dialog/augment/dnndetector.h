@@ -0,0 +1,46 @@
+#ifndef DNNDETECTOR_H
+#define DNNDETECTOR_H
+
+#include <opencv2/dnn.hpp>
+#include <QSize>
+#include <QString>
+#include "slicedinference.h"
+
+// Detector chạy model YOLO xuất ONNX bằng cv::dnn, dùng cho auto-label kiểu cắt lát.
+// Nhận cả 2 layout output: v5 [N, anchors, 5 + nc] (có objectness) và v8 [N, 4 + nc, anchors].
+// Tile được letterbox về kích thước input; model chỉ nhận batch 1 thì tự chạy từng tile
+class DnnDetector : public Detector
+{
+public:
+    explicit DnnDetector(const QString &modelPath, const QSize &inputSize = QSize(640, 640));
+
+    bool isLoaded() const { return !m_net.empty(); }
+    const QString &error() const { return m_error; }
+
+    // NMS theo class trong 1 tile, trước khi SlicedInference gộp giữa các tile
+    void setNmsThreshold(double iou) { m_nmsThreshold = iou; }
+
+    QVector<QVector<Detection>> detectBatch(const std::vector<cv::Mat> &images, double minimumScore) override;
+
+private:
+    struct Letterbox {
+        double scale {1.0};
+        int padX {0};
+        int padY {0};
+    };
+
+    static cv::Mat letterbox(const cv::Mat &img, const cv::Size &size, Letterbox *lb);
+    void forward(const std::vector<cv::Mat> &inputs, const std::vector<Letterbox> &boxes,
+                 const std::vector<cv::Size> &tileSizes, double minimumScore,
+                 QVector<QVector<Detection>> *results);
+    QVector<Detection> decode(const cv::Mat &rows, bool objectness, const Letterbox &lb,
+                              const cv::Size &tileSize, double minimumScore) const;
+
+    cv::dnn::Net m_net;
+    cv::Size m_inputSize;
+    double m_nmsThreshold {0.45};
+    bool m_batched {true};
+    QString m_error;
+};
+
+#endif // DNNDETECTOR_H
@@ -0,0 +1,245 @@
+#include "dryrunestimator.h"
+#include "imagetiler.h"
+#include <QtConcurrent/QtConcurrent>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QLocale>
+#include <QMap>
+#include <QTextStream>
+#include <QDebug>
+#include <algorithm>
+
+namespace {
+
+QString formatDuration(qint64 ms)
+{
+    qint64 s = (ms + 500) / 1000;
+    if (s >= 3600)
+        return QString("%1 h %2 min").arg(s / 3600).arg((s / 60) % 60, 2, 10, QChar('0'));
+    if (s >= 60)
+        return QString("%1 min %2 s").arg(s / 60).arg(s % 60, 2, 10, QChar('0'));
+    return QString("%1 s").arg(s);
+}
+
+// cùng định dạng dòng với YoloLabel::write
+qint64 labelBytes(const QVector<BBox> &boxes)
+{
+    QString text;
+    QTextStream out(&text);
+    for (const auto &b : boxes)
+        out << b.cls << " " << b.xc << " " << b.yc << " " << b.w << " " << b.h << "\n";
+    out.flush();
+    return text.toUtf8().size();
+}
+
+}
+
+QStringList DryRunEstimator::progressStages()
+{
+    return {"probe", "calibrate"};
+}
+
+QString DryRunEstimator::Estimate::summary() const
+{
+    QLocale locale;
+    QString text = QString("~%1 files (%2 images + %3 labels), ~%4, ~%5 from %6 sources")
+                       .arg(files())
+                       .arg(images)
+                       .arg(labels)
+                       .arg(locale.formattedDataSize(bytes()))
+                       .arg(formatDuration(runtimeMs))
+                       .arg(sources);
+
+    QStringList perFormat;
+    for (const auto &f : formats) {
+        perFormat << QString("%1->%2 %3 B/px%4")
+                         .arg(f.sourceSuffix, f.outputSuffix)
+                         .arg(f.bytesPerPixel, 0, 'f', 2)
+                         .arg(f.samples > 0 ? QString() : QString(" (not calibrated)"));
+    }
+    if (!perFormat.isEmpty())
+        text += "; " + perFormat.join(", ");
+    return text;
+}
+
+void DryRunEstimator::setEncoderProfile(const EncoderProfile &profile)
+{
+    m_profile = profile;
+}
+
+void DryRunEstimator::setCalibrationSamples(int perFormat)
+{
+    m_calibrationSamples = std::max(1, perFormat);
+}
+
+void DryRunEstimator::setThreads(int decodeThreads, int encodeThreads)
+{
+    m_decodeThreads = std::max(1, decodeThreads);
+    m_encodeThreads = std::max(1, encodeThreads);
+}
+
+void DryRunEstimator::setProgress(ProgressChannel *channel)
+{
+    m_progress = channel;
+}
+
+DryRunEstimator::Estimate DryRunEstimator::estimate(const QVector<VirtualSample> &samples)
+{
+    Estimate est;
+
+    // ảnh nguồn khác nhau, theo thứ tự xuất hiện
+    QStringList sources;
+    QHash<QString, int> sourceId;
+    QVector<int> sampleSource(samples.size());
+    for (int i = 0; i < samples.size(); ++i) {
+        int id = sourceId.value(samples[i].sourcePath, -1);
+        if (id < 0) {
+            id = sources.size();
+            sourceId.insert(samples[i].sourcePath, id);
+            sources << samples[i].sourcePath;
+        }
+        sampleSource[i] = id;
+    }
+    est.sources = sources.size();
+    if (m_progress)
+        m_progress->addTotal(sources.size());
+
+    // kích thước chỉ đọc header, xoay theo EXIF như cv::imread
+    QVector<QSize> sizes = QtConcurrent::blockingMapped<QVector<QSize>>(sources, [this](const QString &path) {
+        ProgressChannel::StageTimer t(m_progress, StageProbe);
+        QImageReader reader(path);
+        reader.setAutoTransform(true);
+        QSize size = reader.size();
+        if (reader.transformation() & QImageIOHandler::TransformationRotate90)
+            size.transpose();
+        if (m_progress) {
+            if (size.isValid())
+                m_progress->itemDone();
+            else
+                m_progress->itemFailed();
+        }
+        return size;
+    });
+
+    // pixel output: tile -> vùng cắt, còn lại -> cả ảnh ở mức scale (xoay/lật không đổi số pixel)
+    QMap<QString, Format> formats;
+    QMap<QString, QVector<int>> members;
+    QVector<qint64> samplePixels(samples.size(), 0);
+    qint64 boxes = 0;
+    for (int i = 0; i < samples.size(); ++i) {
+        const VirtualSample &s = samples[i];
+        QSize src = sizes[sampleSource[i]];
+        if (!src.isValid()) continue;
+
+        if (!s.crop.empty()) {
+            samplePixels[i] = qint64(s.crop.width) * s.crop.height;
+        } else {
+            QSize size = s.scale != 1.0 ? ImageTiler::levelSize(src.width(), src.height(), s.scale) : src;
+            samplePixels[i] = qint64(size.width()) * size.height();
+        }
+
+        QString suffix = QFileInfo(s.sourcePath).suffix().toLower();
+        Format &f = formats[suffix];
+        f.sourceSuffix = suffix;
+        f.outputSuffix = m_profile.suffixFor(suffix).toLower();
+        f.files++;
+        f.pixels += samplePixels[i];
+        members[suffix] << i;
+        boxes += s.boxes.size();
+        est.images++;
+    }
+    est.labels = est.images; // mỗi ảnh output kèm 1 file label
+
+    // micro-benchmark: vài sample mỗi định dạng, rải đều trong danh sách, chạy tuần tự để đo tốc độ 1 thread
+    QElapsedTimer calibration;
+    calibration.start();
+    qint64 calibratedBoxes = 0, calibratedLabelBytes = 0;
+    for (auto it = formats.begin(); it != formats.end(); ++it) {
+        Format &f = it.value();
+        const QVector<int> &indices = members[it.key()];
+        int k = std::min(m_calibrationSamples, int(indices.size()));
+
+        qint64 decodeNs = 0, decodePixels = 0, encodeNs = 0, outPixels = 0, bytes = 0;
+        for (int j = 0; j < k; ++j) {
+            ProgressChannel::StageTimer t(m_progress, StageCalibrate);
+            const VirtualSample &s = samples[indices[j * indices.size() / k]];
+
+            QElapsedTimer clock;
+            clock.start();
+            cv::Mat source = cv::imread(s.sourcePath.toStdString());
+            qint64 ns = clock.nsecsElapsed();
+            if (source.empty()) continue;
+
+            clock.restart();
+            cv::Mat img = AugmentManifest::render(source, s);
+            std::vector<uchar> buffer;
+            bool ok = false;
+            try {
+                ok = !img.empty() && cv::imencode("." + f.outputSuffix.toStdString(), img, buffer,
+                                                  m_profile.imwriteParams(f.outputSuffix));
+            } catch (const cv::Exception &ex) {
+                qWarning() << "DryRunEstimator: encode failed for" << s.name << ex.what();
+            }
+            if (!ok) continue;
+
+            decodeNs += ns;
+            decodePixels += qint64(source.total());
+            encodeNs += clock.nsecsElapsed();
+            outPixels += qint64(img.total());
+            bytes += qint64(buffer.size());
+            calibratedBoxes += s.boxes.size();
+            calibratedLabelBytes += labelBytes(s.boxes);
+            f.samples++;
+        }
+
+        if (f.samples > 0 && decodePixels > 0 && outPixels > 0) {
+            f.bytesPerPixel = double(bytes) / outPixels;
+            f.decodeNsPerPixel = double(decodeNs) / decodePixels;
+            f.encodeNsPerPixel = double(encodeNs) / outPixels;
+        }
+    }
+    est.calibrationMs = calibration.elapsed();
+
+    // định dạng không calibrate được (mọi sample lỗi) dùng trung bình của các định dạng còn lại
+    Format mean;
+    int calibrated = 0;
+    for (const Format &f : formats) {
+        if (f.samples == 0) continue;
+        mean.bytesPerPixel += f.bytesPerPixel;
+        mean.decodeNsPerPixel += f.decodeNsPerPixel;
+        mean.encodeNsPerPixel += f.encodeNsPerPixel;
+        calibrated++;
+    }
+    if (calibrated > 0) {
+        mean.bytesPerPixel /= calibrated;
+        mean.decodeNsPerPixel /= calibrated;
+        mean.encodeNsPerPixel /= calibrated;
+    }
+    for (Format &f : formats) {
+        if (f.samples > 0) continue;
+        f.bytesPerPixel = mean.bytesPerPixel;
+        f.decodeNsPerPixel = mean.decodeNsPerPixel;
+        f.encodeNsPerPixel = mean.encodeNsPerPixel;
+    }
+
+    // ảnh nguồn decode 1 lần cho mọi output của nó (tile mọi mức, mọi variant)
+    double decodeNs = 0.0, encodeNs = 0.0;
+    for (int id = 0; id < sources.size(); ++id) {
+        if (!sizes[id].isValid()) continue;
+        const Format &f = formats.value(QFileInfo(sources[id]).suffix().toLower(), mean);
+        decodeNs += double(sizes[id].width()) * sizes[id].height() * f.decodeNsPerPixel;
+    }
+    for (Format &f : formats) {
+        f.bytes = qint64(f.pixels * f.bytesPerPixel);
+        est.imageBytes += f.bytes;
+        encodeNs += f.pixels * f.encodeNsPerPixel;
+        est.formats << f;
+    }
+    if (calibratedBoxes > 0)
+        est.labelBytes = qint64(double(boxes) * calibratedLabelBytes / calibratedBoxes);
+    est.runtimeMs = qint64((decodeNs / m_decodeThreads + encodeNs / m_encodeThreads) / 1e6);
+
+    qDebug() << "DryRunEstimator:" << est.summary() << "- calibration" << est.calibrationMs << "ms";
+    return est;
+}
@@ -0,0 +1,67 @@
+#ifndef DRYRUNESTIMATOR_H
+#define DRYRUNESTIMATOR_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "encoderprofile.h"
+#include "progresschannel.h"
+#include "virtualaugment.h"
+
+// Ước lượng trước khi Generate: số file, dung lượng, thời gian chạy.
+// Đầu vào là sample ảo (nhóm bbox, đặt tile, sample policy đều chỉ tính trên label + kích thước đọc từ header);
+// chỉ vài ảnh calibration mỗi định dạng được decode/render/encode thật để đo byte/pixel và ns/pixel trên máy này
+class DryRunEstimator
+{
+public:
+    // Đo được từ các ảnh calibration của 1 định dạng nguồn
+    struct Format {
+        QString sourceSuffix;
+        QString outputSuffix;
+        int samples {0};        // số ảnh calibration
+        int files {0};          // số ảnh output của định dạng này
+        qint64 pixels {0};      // tổng pixel output
+        qint64 bytes {0};       // ước lượng
+        double bytesPerPixel {0.0};
+        double decodeNsPerPixel {0.0};  // theo pixel ảnh nguồn
+        double encodeNsPerPixel {0.0};  // render + encode, theo pixel output
+    };
+
+    struct Estimate {
+        int sources {0};
+        int images {0};
+        int labels {0};
+        qint64 imageBytes {0};
+        qint64 labelBytes {0};
+        qint64 runtimeMs {0};       // decode + render + encode, đã chia cho số thread
+        qint64 calibrationMs {0};
+        QVector<Format> formats;
+
+        int files() const { return images + labels; }
+        qint64 bytes() const { return imageBytes + labelBytes; }
+        QString summary() const;
+    };
+
+    enum ProgressStage { StageProbe, StageCalibrate };
+    static QStringList progressStages();
+
+    DryRunEstimator() = default;
+
+    void setEncoderProfile(const EncoderProfile &profile);
+    void setCalibrationSamples(int perFormat);    // mặc định 3 ảnh mỗi định dạng nguồn
+    // Số thread thực tế của đường ghi: vd. Flip/Rotate chạy tuần tự, Tile decode tuần tự nhưng encode song song
+    void setThreads(int decodeThreads, int encodeThreads);
+    void setProgress(ProgressChannel *channel);   // mỗi ảnh nguồn là 1 item
+
+    Estimate estimate(const QVector<VirtualSample> &samples);
+
+private:
+    EncoderProfile m_profile {EncoderProfile::byName("source")};
+    int m_calibrationSamples {3};
+    int m_decodeThreads {1};
+    int m_encodeThreads {1};
+    ProgressChannel *m_progress {nullptr};
+};
+
+#endif // DRYRUNESTIMATOR_H
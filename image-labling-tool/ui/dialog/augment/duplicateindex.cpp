@@ -0,0 +1,315 @@
+#include "duplicateindex.h"
+#include "imagehash.h"
+#include <QtConcurrent/QtConcurrent>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const char kMagic[8] = {'D', 'U', 'P', 'I', 'D', 'X', '0', '1'};
+
+struct FileHeader {
+    char magic[8];
+    quint32 imageCount;
+    quint32 reserved;
+};
+
+// mỗi ảnh: record cố định rồi tới đường dẫn utf8
+struct FileRecord {
+    qint64 size;
+    qint64 mtime;
+    quint64 dHash;
+    quint64 pHash;
+    quint32 valid;
+    quint32 pathLength;
+};
+
+// hash kém hơn vài bit không đáng kể, decode nhỏ hơn 64x thì đáng
+const int kHashMinSide = 32;
+
+quint16 chunkOf(quint64 hash, int k)
+{
+    return quint16(hash >> (16 * k));
+}
+
+// mọi giá trị 16 bit có <= bits bit 1: XOR với đoạn của query ra các bucket cần dò
+QVector<quint16> masksWithin(int bits)
+{
+    QVector<quint16> masks;
+    for (int v = 0; v < 0x10000; ++v) {
+        if (int(qPopulationCount(quint16(v))) <= bits)
+            masks << quint16(v);
+    }
+    return masks;
+}
+
+}
+
+QStringList DuplicateIndex::progressStages()
+{
+    return {"stat", "hash"};
+}
+
+QString DuplicateIndex::defaultPath(const QString &imageDir)
+{
+    return QDir(imageDir).filePath(".duplicate_index.bin");
+}
+
+void DuplicateIndex::clear()
+{
+    m_entries.clear();
+    m_idByPath.clear();
+    for (int k = 0; k < Chunks; ++k) {
+        m_begin[k].clear();
+        m_ids[k].clear();
+    }
+    m_stats = Stats();
+}
+
+void DuplicateIndex::setProgress(ProgressChannel *channel)
+{
+    m_progress = channel;
+}
+
+bool DuplicateIndex::save(const QString &path) const
+{
+    // ghi file tạm rồi đổi tên -> process khác / lần mở sau không bao giờ thấy file dở
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "DuplicateIndex: cannot write" << path;
+        return false;
+    }
+
+    FileHeader header;
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.imageCount = quint32(m_entries.size());
+    header.reserved = 0;
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    for (const Entry &e : m_entries) {
+        QByteArray utf8 = e.imagePath.toUtf8();
+        FileRecord record {e.size, e.mtime, e.dHash, e.pHash, quint32(e.valid), quint32(utf8.size())};
+        file.write(reinterpret_cast<const char *>(&record), sizeof(record));
+        file.write(utf8);
+    }
+    return file.commit();
+}
+
+bool DuplicateIndex::load(const QString &path)
+{
+    clear();
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    qint64 fileSize = file.size();
+    const uchar *map = fileSize >= qint64(sizeof(FileHeader)) ? file.map(0, fileSize) : nullptr;
+    if (!map)
+        return false;
+
+    FileHeader header;
+    std::memcpy(&header, map, sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) {
+        qWarning() << "DuplicateIndex: bad magic in" << path;
+        return false;
+    }
+
+    qint64 offset = sizeof(FileHeader);
+    m_entries.reserve(int(header.imageCount));
+    for (quint32 i = 0; i < header.imageCount; ++i) {
+        FileRecord record;
+        if (offset + qint64(sizeof(record)) > fileSize) break;
+        std::memcpy(&record, map + offset, sizeof(record));
+        offset += sizeof(record);
+        if (offset + record.pathLength > fileSize) break;
+
+        Entry e;
+        e.imagePath = QString::fromUtf8(reinterpret_cast<const char *>(map + offset), int(record.pathLength));
+        e.size = record.size;
+        e.mtime = record.mtime;
+        e.dHash = record.dHash;
+        e.pHash = record.pHash;
+        e.valid = record.valid != 0;
+        offset += record.pathLength;
+
+        m_idByPath.insert(e.imagePath, m_entries.size());
+        m_entries.push_back(e);
+    }
+
+    if (m_entries.size() != int(header.imageCount)) {
+        qWarning() << "DuplicateIndex: truncated file" << path;
+        clear();
+        return false;
+    }
+
+    rebuildTables();
+    return true;
+}
+
+const DuplicateIndex::Stats &DuplicateIndex::update(const QStringList &imagePaths)
+{
+    QElapsedTimer timer;
+    timer.start();
+    m_stats = Stats();
+    m_stats.images = imagePaths.size();
+    if (m_progress)
+        m_progress->addTotal(imagePaths.size());
+
+    // stat song song (trên NFS mỗi stat là 1 round trip); các worker chỉ đọc index cũ
+    const QVector<Entry> &entries = m_entries;
+    const QHash<QString, int> &idByPath = m_idByPath;
+    QVector<Entry> fresh =
+        QtConcurrent::blockingMapped<QVector<Entry>>(imagePaths, [this, &entries, &idByPath](const QString &path) {
+            ProgressChannel::StageTimer t(m_progress, StageStat);
+            Entry e;
+            e.imagePath = path;
+            QFileInfo info(path);
+            e.size = info.size();
+            e.mtime = info.lastModified().toMSecsSinceEpoch();
+
+            int id = idByPath.value(path, -1);
+            if (id >= 0 && entries[id].size == e.size && entries[id].mtime == e.mtime)
+                return entries[id];
+            return e;
+        });
+
+    // ảnh mới/đã đổi: size/mtime trong index khác -> hash lại
+    QVector<int> stale;
+    for (int i = 0; i < fresh.size(); ++i) {
+        int id = m_idByPath.value(fresh[i].imagePath, -1);
+        if (id < 0 || m_entries[id].size != fresh[i].size || m_entries[id].mtime != fresh[i].mtime)
+            stale << i;
+    }
+    m_stats.reused = fresh.size() - stale.size();
+    if (m_progress)
+        m_progress->itemsDone(m_stats.reused);
+
+    Entry *data = fresh.data();
+    QtConcurrent::blockingMap(stale, [this, data](int i) {
+        ProgressChannel::StageTimer t(m_progress, StageHash);
+        Entry &e = data[i];
+        cv::Mat gray = ImageHash::decodeReduced(e.imagePath, kHashMinSide);
+        e.valid = !gray.empty();
+        if (e.valid) {
+            e.dHash = ImageHash::dHash(gray);
+            e.pHash = ImageHash::pHash(gray);
+        }
+        if (m_progress) {
+            if (e.valid)
+                m_progress->itemDone();
+            else
+                m_progress->itemFailed();
+        }
+    });
+
+    for (int i : stale) {
+        const Entry &e = fresh[i];
+        if (!e.valid) m_stats.failed++;
+        int id = m_idByPath.value(e.imagePath, -1);
+        if (id >= 0) {
+            m_entries[id] = e;
+        } else {
+            m_idByPath.insert(e.imagePath, m_entries.size());
+            m_entries.push_back(e);
+        }
+    }
+    m_stats.hashed = stale.size() - m_stats.failed;
+
+    rebuildTables();
+    m_stats.elapsedMs = timer.elapsed();
+    qDebug() << "DuplicateIndex:" << m_stats.hashed << "hashed," << m_stats.reused << "reused,"
+             << m_stats.failed << "failed in" << m_stats.elapsedMs << "ms";
+    return m_stats;
+}
+
+void DuplicateIndex::rebuildTables()
+{
+    // counting sort theo giá trị đoạn: mỗi bảng là 1 mảng id liền nhau + offset của 65536 bucket
+    for (int k = 0; k < Chunks; ++k) {
+        QVector<quint32> &begin = m_begin[k];
+        QVector<quint32> &ids = m_ids[k];
+        begin.fill(0, 0x10001);
+        for (const Entry &e : m_entries) {
+            if (e.valid) begin[chunkOf(e.pHash, k) + 1]++;
+        }
+        for (int v = 0; v < 0x10000; ++v)
+            begin[v + 1] += begin[v];
+
+        ids.resize(int(begin[0x10000]));
+        QVector<quint32> next = begin;
+        for (int id = 0; id < m_entries.size(); ++id) {
+            if (m_entries[id].valid)
+                ids[int(next[chunkOf(m_entries[id].pHash, k)]++)] = quint32(id);
+        }
+    }
+}
+
+QVector<int> DuplicateIndex::queryIds(quint64 pHash, quint64 dHash, int radius,
+                                      const QVector<quint16> &masks) const
+{
+    // có thể trùng id (khớp ở nhiều đoạn)
+    QVector<int> result;
+    if (m_begin[0].isEmpty()) return result;
+
+    for (int k = 0; k < Chunks; ++k) {
+        quint16 chunk = chunkOf(pHash, k);
+        for (quint16 mask : masks) {
+            quint16 v = chunk ^ mask;
+            for (quint32 i = m_begin[k][v]; i < m_begin[k][v + 1]; ++i) {
+                const Entry &e = m_entries[int(m_ids[k][int(i)])];
+                if (ImageHash::distance(e.pHash, pHash) <= radius && ImageHash::distance(e.dHash, dHash) <= radius)
+                    result << int(m_ids[k][int(i)]);
+            }
+        }
+    }
+    return result;
+}
+
+QVector<int> DuplicateIndex::query(quint64 pHash, quint64 dHash, int radius) const
+{
+    QVector<int> ids = queryIds(pHash, dHash, radius, masksWithin(std::max(0, radius) / Chunks));
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    return ids;
+}
+
+QHash<QString, QString> DuplicateIndex::duplicates(const QStringList &imagePaths, int radius) const
+{
+    radius = std::max(0, radius);
+    QVector<quint16> masks = masksWithin(radius / Chunks);
+
+    // vị trí trong danh sách; ảnh ngoài danh sách (thư mục khác) không được gom
+    QVector<int> order(m_entries.size(), -1);
+    QVector<int> ids;
+    for (const QString &path : imagePaths) {
+        int id = imageId(path);
+        if (id < 0 || !m_entries[id].valid || order[id] >= 0) continue;
+        order[id] = ids.size();
+        ids << id;
+    }
+
+    // chỉ ảnh giữ lại mới phải query -> dataset càng nhiều frame trùng càng nhanh
+    QHash<QString, QString> result;
+    QVector<bool> assigned(ids.size(), false);
+    for (int pos = 0; pos < ids.size(); ++pos) {
+        if (assigned[pos]) continue;
+        assigned[pos] = true;
+
+        const Entry &keeper = m_entries[ids[pos]];
+        for (int id : queryIds(keeper.pHash, keeper.dHash, radius, masks)) {
+            int q = order[id];
+            if (q < 0 || assigned[q]) continue;
+            assigned[q] = true;
+            result.insert(m_entries[id].imagePath, keeper.imagePath);
+        }
+    }
+    return result;
+}
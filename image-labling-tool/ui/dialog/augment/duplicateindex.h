@@ -0,0 +1,78 @@
+#ifndef DUPLICATEINDEX_H
+#define DUPLICATEINDEX_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "progresschannel.h"
+
+// Chỉ mục ảnh gần trùng (vd. các frame liên tiếp của video) cho cả dataset.
+// Mỗi ảnh lưu dHash + pHash tính từ bản decode thu nhỏ; lưu ra file, lần sau chỉ hash lại ảnh mới hoặc đã đổi (size/mtime).
+// Tìm theo bán kính Hamming bằng multi-index hashing: pHash chia 4 đoạn 16 bit, mỗi đoạn 1 bảng;
+// 2 hash cách nhau <= r thì có ít nhất 1 đoạn cách nhau <= r/4 -> chỉ dò vài bucket thay vì so với mọi ảnh
+class DuplicateIndex
+{
+public:
+    struct Entry {
+        QString imagePath;
+        qint64 size {-1};
+        qint64 mtime {-1};
+        quint64 dHash {0};
+        quint64 pHash {0};
+        bool valid {false};  // false -> không decode được
+    };
+
+    struct Stats {
+        int images {0};
+        int hashed {0};     // decode + hash ở lần update này
+        int reused {0};     // lấy lại từ file index
+        int failed {0};
+        qint64 elapsedMs {0};
+    };
+
+    enum ProgressStage { StageStat, StageHash };
+    static QStringList progressStages();
+
+    DuplicateIndex() = default;
+
+    // File index mặc định của 1 thư mục ảnh (ẩn, đuôi không phải ảnh -> scanner bỏ qua)
+    static QString defaultPath(const QString &imageDir);
+
+    void clear();
+    bool load(const QString &path);
+    bool save(const QString &path) const;
+
+    void setProgress(ProgressChannel *channel);  // mỗi ảnh là 1 item
+
+    // Hash song song các ảnh chưa có hoặc đã đổi; ảnh không có trong danh sách vẫn được giữ (vd. quét độ sâu khác)
+    const Stats &update(const QStringList &imagePaths);
+    const Stats &stats() const { return m_stats; }
+
+    int size() const { return m_entries.size(); }
+    int imageId(const QString &imagePath) const { return m_idByPath.value(imagePath, -1); }
+    const Entry &entry(int id) const { return m_entries[id]; }
+
+    // Ảnh có pHash và dHash đều cách hash <= radius
+    QVector<int> query(quint64 pHash, quint64 dHash, int radius) const;
+
+    // Gom nhóm theo thứ tự imagePaths: ảnh đầu tiên của nhóm được giữ, các ảnh gần trùng với nó là bản trùng.
+    // Trả về bản trùng -> ảnh giữ lại; ảnh chưa có trong index không bao giờ là bản trùng
+    QHash<QString, QString> duplicates(const QStringList &imagePaths, int radius) const;
+
+private:
+    static constexpr int Chunks = 4;
+
+    void rebuildTables();
+    QVector<int> queryIds(quint64 pHash, quint64 dHash, int radius, const QVector<quint16> &masks) const;
+
+    QVector<Entry> m_entries;
+    QHash<QString, int> m_idByPath;
+    // bảng đoạn k: id của các ảnh có đoạn == v nằm trong m_ids[k][m_begin[k][v] .. m_begin[k][v+1])
+    QVector<quint32> m_begin[Chunks];
+    QVector<quint32> m_ids[Chunks];
+    ProgressChannel *m_progress {nullptr};
+    Stats m_stats;
+};
+
+#endif // DUPLICATEINDEX_H
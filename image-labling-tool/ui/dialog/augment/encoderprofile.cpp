@@ -0,0 +1,164 @@
+#include "encoderprofile.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QList>
+#include <QSaveFile>
+#include <QDebug>
+
+namespace {
+
+// giá trị của cv::IMWRITE_JPEG_SAMPLING_FACTOR_* (OpenCV >= 4.6)
+const int kSampling420 = 0x221111;
+
+QList<EncoderProfile> presets()
+{
+    QList<EncoderProfile> list;
+
+    // giữ nguyên hành vi cũ: đuôi gốc, tham số mặc định của thư viện
+    EncoderProfile source;
+    source.name = "source";
+    source.pngCompression = -1;
+    source.jpegQuality = -1;
+    list << source;
+
+    // ưu tiên tốc độ: PNG nén nhẹ kiểu RLE, JPEG 4:2:0
+    EncoderProfile fast;
+    fast.name = "fast";
+    fast.jpegQuality = 90;
+    fast.jpegSampling = kSampling420;
+    fast.pngCompression = 1;
+    fast.pngStrategy = cv::IMWRITE_PNG_STRATEGY_RLE;
+    list << fast;
+
+    // cân bằng: mọi output về JPEG chất lượng cao
+    EncoderProfile balanced;
+    balanced.name = "balanced";
+    balanced.format = "jpg";
+    balanced.jpegQuality = 95;
+    balanced.jpegSampling = kSampling420;
+    balanced.jpegOptimize = true;
+    list << balanced;
+
+    // lưu trữ: lossless, nén tối đa
+    EncoderProfile archival;
+    archival.name = "archival";
+    archival.format = "png";
+    archival.pngCompression = 9;
+    archival.pngStrategy = cv::IMWRITE_PNG_STRATEGY_DEFAULT;
+    list << archival;
+
+    EncoderProfile webp;
+    webp.name = "webp";
+    webp.format = "webp";
+    webp.webpQuality = 90;
+    list << webp;
+
+    return list;
+}
+
+}
+
+QStringList EncoderProfile::names()
+{
+    QStringList result;
+    for (const auto &p : presets())
+        result << p.name;
+    return result;
+}
+
+EncoderProfile EncoderProfile::byName(const QString &name)
+{
+    const QList<EncoderProfile> list = presets();
+    for (const auto &p : list) {
+        if (p.name.compare(name, Qt::CaseInsensitive) == 0)
+            return p;
+    }
+    return list.first();
+}
+
+QString EncoderProfile::suffixFor(const QString &sourceSuffix) const
+{
+    return format.isEmpty() ? sourceSuffix : format;
+}
+
+std::vector<int> EncoderProfile::imwriteParams(const QString &suffix) const
+{
+    std::vector<int> params;
+    QString ext = suffix.toLower();
+
+    if (ext == "jpg" || ext == "jpeg") {
+        if (jpegQuality >= 0)
+            params.insert(params.end(), {cv::IMWRITE_JPEG_QUALITY, jpegQuality});
+        if (jpegOptimize)
+            params.insert(params.end(), {cv::IMWRITE_JPEG_OPTIMIZE, 1});
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR >= 6)
+        if (jpegSampling)
+            params.insert(params.end(), {cv::IMWRITE_JPEG_SAMPLING_FACTOR, jpegSampling});
+#endif
+    } else if (ext == "png") {
+        if (pngCompression >= 0) {
+            params.insert(params.end(), {cv::IMWRITE_PNG_COMPRESSION, pngCompression});
+            params.insert(params.end(), {cv::IMWRITE_PNG_STRATEGY, pngStrategy});
+        }
+    } else if (ext == "webp") {
+        params.insert(params.end(), {cv::IMWRITE_WEBP_QUALITY, webpQuality});
+    }
+    return params;
+}
+
+qint64 EncoderProfile::write(const cv::Mat &img, const QString &pathWithoutSuffix,
+                             const QString &sourceSuffix, QString *outPath,
+                             qint64 *encodeNs) const
+{
+    QString ext = suffixFor(sourceSuffix);
+    QString path = pathWithoutSuffix + "." + ext;
+    if (outPath) *outPath = path;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    std::vector<uchar> buffer;
+    bool ok = false;
+    try {
+        ok = cv::imencode("." + ext.toStdString(), img, buffer, imwriteParams(ext));
+    } catch (const cv::Exception &ex) {
+        qWarning() << "EncoderProfile: encode failed for" << path << ex.what();
+    }
+    if (encodeNs) *encodeNs = timer.nsecsElapsed();
+    if (!ok) return -1;
+
+    // ghi file tạm rồi rename: process bị kill giữa chừng không để lại ảnh cụt,
+    // 2 worker shard cùng ghi 1 variant cũng không xen lẫn nội dung
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "EncoderProfile: cannot write" << path;
+        return -1;
+    }
+    qint64 written = file.write(reinterpret_cast<const char *>(buffer.data()), qint64(buffer.size()));
+    if (written != qint64(buffer.size()) || !file.commit())
+        return -1;
+    return written;
+}
+
+void EncodeStats::add(qint64 fileBytes, qint64 ns)
+{
+    files++;
+    bytes += fileBytes;
+    encodeNs += ns;
+}
+
+void EncodeStats::merge(const EncodeStats &other)
+{
+    files += other.files.load();
+    bytes += other.bytes.load();
+    encodeNs += other.encodeNs.load();
+}
+
+QString EncodeStats::summary(const QString &profileName) const
+{
+    return QString("profile %1: %2 files, %3 MB, encode %4 ms")
+        .arg(profileName)
+        .arg(files.load())
+        .arg(bytes.load() / (1024.0 * 1024.0), 0, 'f', 1)
+        .arg(encodeNs.load() / 1000000);
+}
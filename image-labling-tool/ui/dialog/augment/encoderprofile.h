@@ -0,0 +1,44 @@
+#ifndef ENCODERPROFILE_H
+#define ENCODERPROFILE_H
+
+#include <opencv2/opencv.hpp>
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <vector>
+
+// Bộ tham số encode đặt tên sẵn: định dạng, chất lượng, mức nén PNG, chroma subsampling
+struct EncoderProfile {
+    QString name;
+    QString format;          // rỗng -> giữ đuôi file gốc
+    int jpegQuality {95};
+    int jpegSampling {0};    // cv::IMWRITE_JPEG_SAMPLING_FACTOR_*, 0 -> mặc định thư viện
+    bool jpegOptimize {false};
+    int pngCompression {1};  // 0..9
+    int pngStrategy {cv::IMWRITE_PNG_STRATEGY_DEFAULT};
+    int webpQuality {90};
+
+    static QStringList names();
+    static EncoderProfile byName(const QString &name); // không có -> "source"
+
+    QString suffixFor(const QString &sourceSuffix) const;
+    std::vector<int> imwriteParams(const QString &suffix) const;
+
+    // Encode ra bộ nhớ rồi ghi file; trả về số byte đã ghi (-1 nếu lỗi)
+    qint64 write(const cv::Mat &img, const QString &pathWithoutSuffix,
+                 const QString &sourceSuffix, QString *outPath = nullptr,
+                 qint64 *encodeNs = nullptr) const;
+};
+
+// Thống kê encode, cộng dồn được từ nhiều thread
+struct EncodeStats {
+    std::atomic<int> files {0};
+    std::atomic<qint64> bytes {0};
+    std::atomic<qint64> encodeNs {0};
+
+    void add(qint64 fileBytes, qint64 ns);
+    void merge(const EncodeStats &other);
+    QString summary(const QString &profileName) const;
+};
+
+#endif // ENCODERPROFILE_H
@@ -0,0 +1,81 @@
+#include "imagehash.h"
+#include <QImageReader>
+#include <algorithm>
+
+namespace ImageHash {
+
+cv::Mat toGray(const cv::Mat &img)
+{
+    cv::Mat gray;
+    if (img.channels() == 3)
+        cv::cvtColor(img, gray, cv::COLOR_BGR2GRAY);
+    else if (img.channels() == 4)
+        cv::cvtColor(img, gray, cv::COLOR_BGRA2GRAY);
+    else
+        gray = img;
+
+    if (gray.depth() != CV_8U)
+        gray.convertTo(gray, CV_8U, gray.depth() == CV_16U ? 1.0 / 256.0 : 1.0);
+    return gray;
+}
+
+quint64 dHash(const cv::Mat &img)
+{
+    if (img.empty()) return 0;
+
+    cv::Mat small;
+    cv::resize(toGray(img), small, cv::Size(9, 8), 0, 0, cv::INTER_AREA);
+
+    quint64 hash = 0;
+    for (int y = 0; y < 8; ++y) {
+        const uchar *row = small.ptr<uchar>(y);
+        for (int x = 0; x < 8; ++x)
+            hash = (hash << 1) | quint64(row[x] < row[x + 1]);
+    }
+    return hash;
+}
+
+quint64 pHash(const cv::Mat &img)
+{
+    if (img.empty()) return 0;
+
+    cv::Mat small, dct;
+    cv::resize(toGray(img), small, cv::Size(32, 32), 0, 0, cv::INTER_AREA);
+    small.convertTo(small, CV_32F);
+    cv::dct(small, dct);
+
+    // 8x8 hệ số góc trên trái; ngưỡng là median của 63 hệ số AC (DC chỉ là độ sáng trung bình)
+    float coeffs[64];
+    for (int y = 0; y < 8; ++y)
+        for (int x = 0; x < 8; ++x)
+            coeffs[y * 8 + x] = dct.at<float>(y, x);
+    float ac[63];
+    std::copy(coeffs + 1, coeffs + 64, ac);
+    std::nth_element(ac, ac + 31, ac + 63);
+    float median = ac[31];
+
+    quint64 hash = 0;
+    for (float c : coeffs)
+        hash = (hash << 1) | quint64(c > median);
+    return hash;
+}
+
+cv::Mat decodeReduced(const QString &path, int minSide)
+{
+    // kích thước chỉ đọc header; không đọc được thì decode đầy đủ
+    QImageReader reader(path);
+    reader.setAutoTransform(false);
+    QSize size = reader.size();
+    int side = size.isValid() ? std::min(size.width(), size.height()) : 0;
+
+    int flag = cv::IMREAD_GRAYSCALE;
+    if (side >= 8 * minSide)
+        flag = cv::IMREAD_REDUCED_GRAYSCALE_8;
+    else if (side >= 4 * minSide)
+        flag = cv::IMREAD_REDUCED_GRAYSCALE_4;
+    else if (side >= 2 * minSide)
+        flag = cv::IMREAD_REDUCED_GRAYSCALE_2;
+    return cv::imread(path.toStdString(), flag);
+}
+
+}
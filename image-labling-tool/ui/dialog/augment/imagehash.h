@@ -0,0 +1,31 @@
+#ifndef IMAGEHASH_H
+#define IMAGEHASH_H
+
+#include <opencv2/opencv.hpp>
+#include <QString>
+#include <QtGlobal>
+
+// Hash cảm nhận 64 bit: ảnh giống nhau về nội dung (khác nén, khác kích thước, chỉnh sáng nhẹ) -> khoảng cách Hamming nhỏ
+namespace ImageHash {
+
+// Ảnh xám 8 bit; ảnh đã xám thì trả lại chính nó (không copy)
+cv::Mat toGray(const cv::Mat &img);
+
+// dHash: so sánh độ sáng 2 pixel kề nhau trên ảnh xám thu về 9x8
+quint64 dHash(const cv::Mat &img);
+
+// pHash: dấu của 64 hệ số DCT tần số thấp trên ảnh xám 32x32, bền với nén/đổi độ sáng hơn dHash
+quint64 pHash(const cv::Mat &img);
+
+// Decode xám ở độ phân giải giảm (libjpeg giải nén thẳng ở 1/2, 1/4, 1/8) nhưng cạnh nhỏ vẫn >= minSide;
+// đủ cho hash mà nhanh hơn decode đầy đủ vài lần
+cv::Mat decodeReduced(const QString &path, int minSide = 32);
+
+inline int distance(quint64 a, quint64 b)
+{
+    return int(qPopulationCount(a ^ b));
+}
+
+}
+
+#endif // IMAGEHASH_H
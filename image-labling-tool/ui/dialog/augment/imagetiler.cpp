@@ -1,10 +1,17 @@
 #include "ImageTiler.h"
 #include <opencv2/opencv.hpp>
-#include <QFile>
 #include <QFileInfo>
-#include <QTextStream>
 #include <QDebug>
+#include <QtConcurrent/QtConcurrent>
+#include <QSet>
 #include <algorithm>
+#include <numeric>
+#include <atomic>
+#include <memory>
+#include <QRegularExpression>
+#include <queue>
+#include <tuple>
+#include "spatialgrid.h"
 
 ImageTiler::ImageTiler(const QString &imagePath, const QString &labelPath)
     : m_imagePath(imagePath), m_labelPath(labelPath)
@@ -14,38 +21,246 @@ void ImageTiler::setTileSize(const QSize &size) {
     m_tileSize = size;
 }
 
+void ImageTiler::setLevels(const QVector<Level> &levels) {
+    if (levels.size() == 1 && levels.first().scale == 1.0) {
+        m_tileSize = levels.first().tileSize;
+        m_levels.clear();
+    } else {
+        m_levels = levels;
+    }
+}
+
+bool ImageTiler::parseLevels(const QString &spec, QVector<Level> *levels, QString *error) {
+    static const QRegularExpression rx("^(\\d+)(?:\\s*x\\s*(\\d+))?(?:\\s*@\\s*([0-9]*\\.?[0-9]+))?$");
+    levels->clear();
+    for (const QString &part : spec.split(',', Qt::SkipEmptyParts)) {
+        QRegularExpressionMatch m = rx.match(part.trimmed());
+        if (!m.hasMatch()) {
+            if (error) *error = QString("Invalid tile level '%1' (expected W x H[@scale])").arg(part.trimmed());
+            return false;
+        }
+        Level level;
+        int w = m.captured(1).toInt();
+        int h = m.captured(2).isEmpty() ? w : m.captured(2).toInt();
+        level.tileSize = QSize(w, h);
+        level.scale = m.captured(3).isEmpty() ? 1.0 : m.captured(3).toDouble();
+        if (w <= 0 || h <= 0 || level.scale <= 0.0 || level.scale > 1.0) {
+            if (error) *error = QString("Invalid tile level '%1' (size > 0, scale in (0, 1])").arg(part.trimmed());
+            return false;
+        }
+        levels->push_back(level);
+    }
+    if (levels->isEmpty()) {
+        if (error) *error = "No tile size given";
+        return false;
+    }
+    return true;
+}
+
 void ImageTiler::setOutputDir(const QString &dir) {
     m_outputDir = dir;
 }
 
+void ImageTiler::setEncoderProfile(const EncoderProfile &profile) {
+    m_profile = profile;
+}
+
+void ImageTiler::setPlacement(Placement placement) {
+    m_placement = placement;
+}
+
+void ImageTiler::setProgress(ProgressChannel *channel) {
+    m_progress = channel;
+}
+
+void ImageTiler::setQualityGate(const TileQualityGate::Options &options) {
+    m_gate = TileQualityGate(options);
+}
+
+QStringList ImageTiler::progressStages() {
+    return {"decode", "plan", "pyramid", "gate", "encode"};
+}
+
 void ImageTiler::loadLabels() {
-    m_boxes.clear();
-    QFile file(m_labelPath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    m_labelsLoaded = true;
+    bool ok = false;
+    m_boxes = YoloLabel::read(m_labelPath, &ok); // cùng parser với label của dialog / runner: bỏ dòng lỗi
+    if (!ok)
         qWarning() << "Cannot open label file:" << m_labelPath;
+}
+
+void ImageTiler::process() {
+    cv::Mat img;
+    {
+        ProgressChannel::StageTimer t(m_progress, StageDecode);
+        img = cv::imread(m_imagePath.toStdString());
+    }
+    if (img.empty()) {
+        qWarning() << "Cannot read image:" << m_imagePath;
+        if (m_progress) m_progress->itemFailed();
         return;
     }
 
-    QTextStream in(&file);
-    while (!in.atEnd()) {
-        int cls; float cx, cy, w, h;
-        in >> cls >> cx >> cy >> w >> h;
-        if (in.status() == QTextStream::Ok) {
-            m_boxes.push_back({cls, cx, cy, w, h});
+    QVector<TilePlan> tiles;
+    {
+        ProgressChannel::StageTimer t(m_progress, StagePlan);
+        tiles = outputTiles(img.cols, img.rows);
+    }
+    if (tiles.isEmpty()) {
+        if (m_progress) m_progress->itemDone();
+        return;
+    }
+
+    // Pyramid: mỗi scale chỉ resize 1 lần từ ảnh gốc (INTER_AREA), các mức chạy song song
+    QVector<double> scales;
+    for (const auto &t : tiles)
+        if (t.scale != 1.0 && !scales.contains(t.scale))
+            scales.push_back(t.scale);
+
+    QHash<double, cv::Mat> pyramid;
+    pyramid.insert(1.0, img);
+    if (!scales.isEmpty()) {
+        ProgressChannel::StageTimer t(m_progress, StagePyramid);
+        QVector<cv::Mat> levels(scales.size());
+        QVector<int> idx(scales.size());
+        std::iota(idx.begin(), idx.end(), 0);
+        QtConcurrent::blockingMap(idx, [&](int i) {
+            QSize size = levelSize(img.cols, img.rows, scales[i]);
+            cv::resize(img, levels[i], cv::Size(size.width(), size.height()), 0, 0, cv::INTER_AREA);
+        });
+        for (int i = 0; i < scales.size(); ++i)
+            pyramid.insert(scales[i], levels[i]);
+    }
+
+    // Cổng chất lượng trước khi encode: đo song song, xét trùng tuần tự theo thứ tự tile
+    // -> tile nào bị bỏ không phụ thuộc số thread
+    QVector<int> order;
+    if (m_gate.options().pixelChecks()) {
+        ProgressChannel::StageTimer t(m_progress, StageGate);
+        QVector<TileQualityGate::Measure> measures(tiles.size());
+        QVector<int> idx(tiles.size());
+        std::iota(idx.begin(), idx.end(), 0);
+        QtConcurrent::blockingMap(idx, [this, &pyramid, &tiles, &measures](int i) {
+            measures[i] = m_gate.measure(pyramid.value(tiles[i].scale)(tiles[i].roi));
+        });
+
+        QVector<quint64> acceptedHashes; // hash các tile đã nhận của ảnh nguồn này
+        for (int i = 0; i < tiles.size(); ++i) {
+            TileQualityGate::Reason reason = m_gate.check(measures[i]);
+            if (reason == TileQualityGate::Accepted && m_gate.isDuplicate(measures[i].hash, acceptedHashes))
+                reason = TileQualityGate::Duplicate;
+            m_gateStats.add(reason);
+            if (reason == TileQualityGate::Accepted) {
+                order.push_back(i);
+                acceptedHashes.push_back(measures[i].hash);
+            }
         }
+    } else {
+        order.resize(tiles.size());
+        std::iota(order.begin(), order.end(), 0);
+        m_gateStats.count[TileQualityGate::Accepted] += tiles.size();
+    }
+
+    // 6) Encode các tile song song (ROI tham chiếu thẳng vào ảnh của mức, không clone)
+    std::atomic<int> failed {0};
+    QtConcurrent::blockingMap(order, [this, &pyramid, &tiles, &failed](int i) {
+        if (!saveTile(pyramid.value(tiles[i].scale)(tiles[i].roi), tiles[i]))
+            failed++;
+    });
+
+    // ảnh nguồn là 1 item: tile nào ghi lỗi thì cả ảnh tính là lỗi
+    if (m_progress) {
+        if (failed > 0)
+            m_progress->itemFailed();
+        else
+            m_progress->itemDone();
     }
+    qDebug() << "Generated" << order.size() - failed << "tiles for" << m_imagePath
+             << "(" << tiles.size() - order.size() << "rejected by gate," << failed << "failed )";
 }
 
-void ImageTiler::process() {
-    cv::Mat img = cv::imread(m_imagePath.toStdString());
-    if (img.empty()) {
-        qWarning() << "Cannot read image:" << m_imagePath;
-        return;
+QSize ImageTiler::levelSize(int imgWidth, int imgHeight, double scale) {
+    return QSize(std::max(1, qRound(imgWidth * scale)), std::max(1, qRound(imgHeight * scale)));
+}
+
+QVector<ImageTiler::TilePlan> ImageTiler::outputTiles(int imgWidth, int imgHeight) {
+    if (!m_labelsLoaded)
+        loadLabels();
+    m_gateStats = TileQualityGate::Stats();
+
+    QString baseName = QFileInfo(m_imagePath).completeBaseName();
+    if (m_levels.isEmpty()) {
+        QVector<TilePlan> tiles = levelTiles(imgWidth, imgHeight);
+        for (int i = 0; i < tiles.size(); ++i)
+            tiles[i].name = QString("%1[%2]").arg(baseName).arg(i + 1);
+        return tiles;
+    }
+
+    // planTiles() ghi vào member -> mỗi mức một tiler con; label YOLO chuẩn hoá nên dùng chung cho mọi mức
+    std::vector<std::unique_ptr<ImageTiler>> children;
+    for (const auto &level : m_levels) {
+        auto child = std::make_unique<ImageTiler>(m_imagePath, m_labelPath);
+        child->setTileSize(level.tileSize);
+        child->setPlacement(m_placement);
+        child->m_gate = m_gate;
+        child->m_boxes = m_boxes;
+        child->m_labelsLoaded = true;
+        children.push_back(std::move(child));
     }
-    m_imgWidth = img.cols;
-    m_imgHeight = img.rows;
 
-    loadLabels();
+    QVector<QVector<TilePlan>> perLevel(m_levels.size());
+    QVector<int> idx(m_levels.size());
+    std::iota(idx.begin(), idx.end(), 0);
+    QtConcurrent::blockingMap(idx, [&](int k) {
+        double scale = m_levels[k].scale;
+        QSize size = levelSize(imgWidth, imgHeight, scale);
+        perLevel[k] = children[k]->levelTiles(size.width(), size.height());
+        for (auto &t : perLevel[k]) {
+            t.level = k;
+            t.scale = scale;
+            // gốc tile theo toạ độ ảnh gốc để tile của các mức so được với nhau
+            t.name = QString("%1[L%2_x%3_y%4]").arg(baseName).arg(k)
+                         .arg(qRound(t.roi.x / scale)).arg(qRound(t.roi.y / scale));
+        }
+    });
+
+    m_report = Report();
+    QVector<TilePlan> tiles;
+    for (int k = 0; k < m_levels.size(); ++k) {
+        const Report &r = children[k]->report();
+        m_report.eligibleBoxes += r.eligibleBoxes;
+        m_report.tiles += r.tiles;
+        m_report.greedyTiles += r.greedyTiles;
+        m_gateStats.merge(children[k]->qualityStats());
+        qDebug() << "Level" << k << ": scale" << m_levels[k].scale << "tile" << m_levels[k].tileSize
+                 << "->" << perLevel[k].size() << "tiles";
+        tiles += perLevel[k];
+    }
+    return tiles;
+}
+
+QVector<ImageTiler::TilePlan> ImageTiler::levelTiles(int imgWidth, int imgHeight) {
+    QVector<TilePlan> tiles;
+    for (const auto &plan : planTiles(imgWidth, imgHeight)) {
+        // 5) Cắt bbox theo tile, giữ phần nằm trong tile (cho phép cắt 1 phần, bỏ mẩu quá nhỏ theo gate)
+        int dropped = 0;
+        QVector<BBox> newBoxes = clipToTile(plan.roi, plan.boxes, m_gate.options().minVisibleFraction, &dropped);
+        m_gateStats.droppedBoxes += dropped;
+        if (!newBoxes.isEmpty())
+            tiles.push_back({plan.roi, newBoxes});
+        else if (dropped > 0)
+            m_gateStats.add(TileQualityGate::Sliver);
+    }
+    return tiles;
+}
+
+QVector<ImageTiler::TilePlan> ImageTiler::planTiles(int imgWidth, int imgHeight) {
+    m_imgWidth = imgWidth;
+    m_imgHeight = imgHeight;
+    m_report = Report();
+
+    if (!m_labelsLoaded)
+        loadLabels();
 
     int tileW = m_tileSize.width();
     int tileH = m_tileSize.height();
@@ -55,32 +270,73 @@ void ImageTiler::process() {
         qDebug() << "Tile size" << tileW << "x" << tileH
                  << "bigger than image" << m_imgWidth << "x" << m_imgHeight
                  << "=> skip tiling for" << m_imagePath;
-        return;
+        return {};
     }
 
-    // 2) Lọc bỏ các bbox lớn hơn tile (nếu bbox rộng/ cao hơn tile thì không tile cho bbox đó)
+    // 2) Lọc bỏ các bbox lớn hơn tile
+    QVector<BBox> filtered = eligibleBoxes();
+    m_report.eligibleBoxes = filtered.size();
+
+    if (filtered.isEmpty()) {
+        qDebug() << "No bbox fits tile size => nothing to tile for" << m_imagePath;
+        return {};
+    }
+
+    QVector<TilePlan> greedy = planGreedy(filtered);
+    m_report.greedyTiles = greedy.size();
+
+    if (m_placement == Placement::Greedy) {
+        m_report.tiles = greedy.size();
+        assignBoxes(greedy);
+        return greedy;
+    }
+
+    QVector<TilePlan> cover = planMinCover(filtered);
+    m_report.tiles = cover.size();
+    qDebug() << "MinCover:" << m_report.tiles << "tiles vs greedy" << m_report.greedyTiles
+             << "for" << m_report.eligibleBoxes << "boxes in" << m_imagePath;
+    assignBoxes(cover);
+    return cover;
+}
+
+void ImageTiler::assignBoxes(QVector<TilePlan> &plans) const {
+    // bbox cắt theo tile ở levelTiles(); phần còn thấy dưới ngưỡng visible của gate bị bỏ ở đó
+    SpatialGrid grid(m_tileSize.width(), m_tileSize.height());
+    for (int i = 0; i < m_boxes.size(); ++i)
+        grid.insert(i, boxRect(m_boxes[i]));
+
+    for (auto &plan : plans) {
+        plan.boxes.clear();
+        for (int i : grid.query(plan.roi))
+            plan.boxes.push_back(m_boxes[i]);
+    }
+}
+
+QVector<BBox> ImageTiler::eligibleBoxes() const {
+    // nếu bbox rộng/ cao hơn tile thì không tile cho bbox đó
     QVector<BBox> filtered;
     for (const auto &b : m_boxes) {
         int bw = int(b.w * m_imgWidth);
         int bh = int(b.h * m_imgHeight);
-        if (bw <= tileW && bh <= tileH) {
+        if (bw <= m_tileSize.width() && bh <= m_tileSize.height()) {
             filtered.push_back(b);
         } else {
             qDebug() << "Skip bbox (bigger than tile):" << b.cls << "bbox_px="
                      << bw << "x" << bh;
         }
     }
+    return filtered;
+}
 
-    if (filtered.isEmpty()) {
-        qDebug() << "No bbox fits tile size => nothing to tile for" << m_imagePath;
-        return;
-    }
+QVector<ImageTiler::TilePlan> ImageTiler::planGreedy(const QVector<BBox> &eligible) const {
+    int tileW = m_tileSize.width();
+    int tileH = m_tileSize.height();
 
     // 3) Gom nhóm bbox gần nhau: greedy - thêm bbox vào nhóm nếu union vẫn <= tile
-    auto groups = groupBBoxes(filtered);
+    auto groups = groupBBoxes(eligible);
 
-    QVector<cv::Rect> savedTiles;
-    int localIndex = 1;
+    QVector<TilePlan> plans;
+    SpatialGrid savedTiles(tileW, tileH); // tile cùng kích thước chỉ giao được tile ở ô lân cận
 
     // 4) Tạo tile cho mỗi group
     for (const auto &g : groups) {
@@ -108,78 +364,189 @@ void ImageTiler::process() {
         // --- tile luôn cố định đúng size chuẩn ---
         cv::Rect roi(roiX, roiY, tileW, tileH);
 
-
         // Tránh trùng tile (IOU cao)
         bool duplicate = false;
-        for (const auto &st : savedTiles) {
-            if (iou(st, roi) > m_iouThresh) {
+        for (int id : savedTiles.query(roi)) {
+            if (iou(savedTiles.rect(id), roi) > m_iouThresh) {
                 duplicate = true;
                 break;
             }
         }
         if (duplicate) continue;
 
-        cv::Mat tile = img(roi).clone();
-
-        // 5) Cắt bbox theo tile, giữ phần nằm trong tile (cho phép cắt 1 phần)
-        QVector<BBox> newBoxes;
-        for (const auto &bb : g) {
-            int bx = int(bb.xc * m_imgWidth);
-            int by = int(bb.yc * m_imgHeight);
-            int bw = int(bb.w * m_imgWidth);
-            int bh = int(bb.h * m_imgHeight);
-
-            int xmin = bx - bw/2, ymin = by - bh/2;
-            int xmax = bx + bw/2, ymax = by + bh/2;
-
-            int nxmin = std::max(xmin, roi.x) - roi.x;
-            int nymin = std::max(ymin, roi.y) - roi.y;
-            int nxmax = std::min(xmax, roi.x + roi.width) - roi.x;
-            int nymax = std::min(ymax, roi.y + roi.height) - roi.y;
-
-            if (nxmin < nxmax && nymin < nymax) {
-                float ncx = (nxmin + nxmax) / 2.0f / float(roi.width);
-                float ncy = (nymin + nymax) / 2.0f / float(roi.height);
-                float nw  = (nxmax - nxmin) / float(roi.width);
-                float nh  = (nymax - nymin) / float(roi.height);
-                newBoxes.push_back({bb.cls, ncx, ncy, nw, nh});
+        // tile chỉ được giữ nếu còn bbox sau khi cắt (giống bước 5)
+        if (clipToTile(roi, g).isEmpty()) continue;
+
+        savedTiles.insert(plans.size(), roi);
+        plans.push_back({roi, g});
+    }
+    return plans;
+}
+
+QVector<ImageTiler::TilePlan> ImageTiler::planMinCover(const QVector<BBox> &eligible) const {
+    int tileW = m_tileSize.width();
+    int tileH = m_tileSize.height();
+    cv::Rect imageRect(0, 0, m_imgWidth, m_imgHeight);
+
+    // sắp xếp để kết quả không phụ thuộc thứ tự dòng trong file label
+    QVector<cv::Rect> rects;
+    for (const auto &b : eligible) {
+        cv::Rect r = boxRect(b) & imageRect;
+        if (!r.empty()) rects.push_back(r);
+    }
+    std::sort(rects.begin(), rects.end(), [](const cv::Rect &a, const cv::Rect &b) {
+        return std::tie(a.y, a.x, a.height, a.width) < std::tie(b.y, b.x, b.height, b.width);
+    });
+
+    SpatialGrid boxGrid(tileW, tileH);
+    for (int i = 0; i < rects.size(); ++i)
+        boxGrid.insert(i, rects[i]);
+
+    // Ứng viên: mọi tile tối ưu đều dịch được về cạnh trái = x1 của 1 bbox và cạnh trên = y1
+    // của 1 bbox khác mà nó chứa -> chỉ cần xét cặp (x1_i, y1_j) với j gần i
+    QSet<quint64> seen;
+    QVector<cv::Rect> candidates;
+    for (const auto &ri : rects) {
+        int x = std::max(0, std::min(ri.x, m_imgWidth - tileW));
+        cv::Rect window(ri.x + ri.width - tileW, ri.y + ri.height - tileH, 2 * tileW, 2 * tileH);
+        for (int j : boxGrid.query(window)) {
+            int y = std::max(0, std::min(rects[j].y, m_imgHeight - tileH));
+            cv::Rect tile(x, y, tileW, tileH);
+            if ((tile & ri) != ri) continue; // ứng viên phải chứa bbox neo
+            quint64 key = (quint64(quint32(x)) << 32) | quint32(y);
+            if (seen.contains(key)) continue;
+            seen.insert(key);
+            candidates.push_back(tile);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const cv::Rect &a, const cv::Rect &b) {
+        return std::tie(a.y, a.x) < std::tie(b.y, b.x);
+    });
+
+    QVector<QVector<int>> covers(candidates.size());
+    for (int c = 0; c < candidates.size(); ++c) {
+        for (int i : boxGrid.query(candidates[c])) {
+            if ((candidates[c] & rects[i]) == rects[i])
+                covers[c].push_back(i);
+        }
+    }
+
+    // Greedy set cover kiểu lazy: gain chỉ giảm dần nên chỉ cần tính lại phần tử ở đỉnh heap
+    std::vector<bool> covered(rects.size(), false);
+    std::vector<int> coverCount(rects.size(), 0);
+    std::priority_queue<std::pair<int, int>> heap; // (gain, -index) -> ưu tiên index nhỏ khi bằng gain
+    for (int c = 0; c < candidates.size(); ++c)
+        heap.push({int(covers[c].size()), -c});
+
+    QVector<int> chosen;
+    int remaining = rects.size();
+    while (remaining > 0 && !heap.empty()) {
+        auto top = heap.top();
+        heap.pop();
+        int c = -top.second;
+
+        int gain = 0;
+        for (int i : covers[c])
+            if (!covered[i]) gain++;
+        if (gain == 0) continue;
+
+        if (!heap.empty() && gain < heap.top().first) {
+            heap.push({gain, -c});
+            continue;
+        }
+
+        chosen.push_back(c);
+        for (int i : covers[c]) {
+            if (!covered[i]) {
+                covered[i] = true;
+                remaining--;
             }
+            coverCount[i]++;
         }
+    }
 
-        if (!newBoxes.isEmpty()) {
-            saveTile(tile, newBoxes, roi.x, roi.y, localIndex);
-            savedTiles.push_back(roi);
-            localIndex++;
+    // bỏ tile thừa: mọi bbox của nó đã nằm trọn trong tile khác
+    QVector<int> kept;
+    for (int k = chosen.size() - 1; k >= 0; --k) {
+        int c = chosen[k];
+        bool redundant = std::all_of(covers[c].begin(), covers[c].end(),
+                                     [&coverCount](int i) { return coverCount[i] > 1; });
+        if (redundant) {
+            for (int i : covers[c]) coverCount[i]--;
+        } else {
+            kept.push_back(c);
         }
     }
+    std::sort(kept.begin(), kept.end());
 
-    qDebug() << "Generated" << (localIndex - 1) << "tiles for" << m_imagePath;
+    QVector<TilePlan> plans;
+    for (int c : kept) {
+        TilePlan plan;
+        plan.roi = candidates[c];
+        plans.push_back(plan); // bbox gán ở assignBoxes()
+    }
+    return plans;
 }
 
-void ImageTiler::saveTile(const cv::Mat &tile, const QVector<BBox> &boxes,
-                          int tileX, int tileY, int localIndex) {
-    QString baseName = QFileInfo(m_imagePath).completeBaseName();
-    QString ext = QFileInfo(m_imagePath).suffix();
+QVector<BBox> ImageTiler::clipToTile(const cv::Rect &roi, const QVector<BBox> &boxes,
+                                     double minVisible, int *dropped) const {
+    QVector<BBox> newBoxes;
+    for (const auto &bb : boxes) {
+        cv::Rect r = boxRect(bb);
+        int xmin = r.x, ymin = r.y;
+        int xmax = r.x + r.width, ymax = r.y + r.height;
+
+        int nxmin = std::max(xmin, roi.x) - roi.x;
+        int nymin = std::max(ymin, roi.y) - roi.y;
+        int nxmax = std::min(xmax, roi.x + roi.width) - roi.x;
+        int nymax = std::min(ymax, roi.y + roi.height) - roi.y;
+
+        if (nxmin < nxmax && nymin < nymax) {
+            if (minVisible > 0.0 && r.area() > 0
+                && double(nxmax - nxmin) * (nymax - nymin) < minVisible * r.area()) {
+                if (dropped) (*dropped)++;
+                continue;
+            }
+            float ncx = (nxmin + nxmax) / 2.0f / float(roi.width);
+            float ncy = (nymin + nymax) / 2.0f / float(roi.height);
+            float nw  = (nxmax - nxmin) / float(roi.width);
+            float nh  = (nymax - nymin) / float(roi.height);
+            newBoxes.push_back({bb.cls, ncx, ncy, nw, nh});
+        }
+    }
+    return newBoxes;
+}
 
-    QString imgName = QString("%1/%2[%3].%4")
-                          .arg(m_outputDir)
-                          .arg(baseName)
-                          .arg(localIndex)
-                          .arg(ext);
+cv::Rect ImageTiler::boxRect(const BBox &bb) const {
+    int bx = int(bb.xc * m_imgWidth);
+    int by = int(bb.yc * m_imgHeight);
+    int bw = int(bb.w * m_imgWidth);
+    int bh = int(bb.h * m_imgHeight);
+    return cv::Rect(bx - bw/2, by - bh/2, (bw/2) * 2, (bh/2) * 2);
+}
 
-    cv::imwrite(imgName.toStdString(), tile);
+bool ImageTiler::saveTile(const cv::Mat &tile, const TilePlan &plan) {
+    QString ext = QFileInfo(m_imagePath).suffix();
+    QString imgBase = m_outputDir + "/" + plan.name;
 
-    QString labelName = imgName;
-    labelName.replace("." + ext, ".txt");
+    qint64 encodeNs = 0;
+    qint64 bytes = m_profile.write(tile, imgBase, ext, nullptr, &encodeNs);
+    if (bytes < 0) {
+        qWarning() << "Cannot write tile:" << imgBase;
+        return false;
+    }
+    m_encodeStats.add(bytes, encodeNs);
+    if (m_progress) {
+        m_progress->stageDone(StageEncode, encodeNs);
+        m_progress->addBytes(bytes);
+    }
 
-    QFile file(labelName);
-    if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QTextStream out(&file);
-        for (const auto &b : boxes) {
-            out << b.cls << " " << b.xc << " " << b.yc << " "
-                << b.w << " " << b.h << "\n";
-        }
+    QString labelPath = YoloLabel::outputLabelPathFor(imgBase, m_imagePath, m_labelPath);
+    if (!YoloLabel::write(labelPath, plan.boxes)) {
+        qWarning() << "Cannot write tile label:" << labelPath;
+        return false;
     }
+    return true;
 }
 
 // --- grouping / utility implementations ---
@@ -217,15 +584,11 @@ cv::Rect ImageTiler::unionGroup(const QVector<BBox> &group) const {
     int xmax = INT_MIN, ymax = INT_MIN;
 
     for (const auto &bb : group) {
-        int bx = int(bb.xc * m_imgWidth);
-        int by = int(bb.yc * m_imgHeight);
-        int bw = int(bb.w * m_imgWidth);
-        int bh = int(bb.h * m_imgHeight);
-
-        int x1 = bx - bw/2;
-        int y1 = by - bh/2;
-        int x2 = bx + bw/2;
-        int y2 = by + bh/2;
+        cv::Rect r = boxRect(bb);
+        int x1 = r.x;
+        int y1 = r.y;
+        int x2 = r.x + r.width;
+        int y2 = r.y + r.height;
 
         xmin = std::min(xmin, x1);
         ymin = std::min(ymin, y1);
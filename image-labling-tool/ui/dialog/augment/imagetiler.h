@@ -5,25 +5,83 @@
 #include <QString>
 #include <QSize>
 #include <QVector>
-
-struct BBox {
-    int cls;
-    float xc, yc, w, h; // YOLO normalized
-};
+#include "yololabel.h"
+#include "encoderprofile.h"
+#include "progresschannel.h"
+#include "tilequalitygate.h"
 
 class ImageTiler
 {
 public:
+    enum class Placement {
+        Greedy,   // mỗi nhóm bbox một tile, bỏ tile trùng theo IoU (cách cũ)
+        MinCover  // set-cover xấp xỉ: ít tile nhất sao cho mọi bbox nằm trọn trong >= 1 tile
+    };
+
+    struct TilePlan {
+        cv::Rect roi;        // toạ độ trong ảnh của mức (level) chứa tile
+        QVector<BBox> boxes; // planTiles: bbox gốc (theo ảnh); outputTiles: bbox đã cắt (theo tile)
+        int level {-1};      // -1: chỉ 1 mức (tên tile cũ [n])
+        double scale {1.0};
+        QString name;        // tên file không đuôi
+    };
+
+    // 1 mức của pyramid: ảnh được thu nhỏ theo scale (INTER_AREA) rồi tile với tileSize
+    struct Level {
+        QSize tileSize;
+        double scale {1.0};
+    };
+
+    struct Report {
+        int eligibleBoxes {0};
+        int tiles {0};
+        int greedyTiles {0}; // số tile nếu dùng Greedy, để so sánh
+    };
+
+    enum ProgressStage { StageDecode, StagePlan, StagePyramid, StageGate, StageEncode };
+    static QStringList progressStages();
+
     ImageTiler(const QString &imagePath, const QString &labelPath);
 
     void setTileSize(const QSize &size);
+    // Nhiều mức trong 1 lần decode; đúng 1 mức scale 1.0 thì giống setTileSize()
+    void setLevels(const QVector<Level> &levels);
+    // "640 x 640, 1024, 640@0.5": W [x H] [@scale], H mặc định = W, scale trong (0, 1]
+    static bool parseLevels(const QString &spec, QVector<Level> *levels, QString *error = nullptr);
     void setOutputDir(const QString &dir);
+    void setEncoderProfile(const EncoderProfile &profile);
+    void setPlacement(Placement placement);
+    void setProgress(ProgressChannel *channel); // mỗi ảnh nguồn là 1 item, byte tính theo tile
+    // visible áp dụng ngay khi lập kế hoạch tile (cả outputTiles), các điều kiện pixel xét trong process() trước encode
+    void setQualityGate(const TileQualityGate::Options &options);
     void process();
 
+    // Chỉ tính hình học (không decode ảnh), dùng kích thước ảnh đã biết
+    QVector<TilePlan> planTiles(int imgWidth, int imgHeight);
+    // Tile sẽ được ghi ra ở mọi mức (bbox đã cắt theo tile, bỏ tile rỗng), kèm tên file;
+    // kích thước là của ảnh gốc, các mức được lập kế hoạch song song
+    QVector<TilePlan> outputTiles(int imgWidth, int imgHeight);
+
+    static QSize levelSize(int imgWidth, int imgHeight, double scale);
+
+    const EncodeStats &encodeStats() const { return m_encodeStats; }
+    const Report &report() const { return m_report; }
+    const TileQualityGate::Stats &qualityStats() const { return m_gateStats; }
+
 private:
     void loadLabels();
-    void saveTile(const cv::Mat &tile, const QVector<BBox> &boxes,
-                  int tileX, int tileY, int localIndex);
+    QVector<BBox> eligibleBoxes() const;
+    QVector<TilePlan> levelTiles(int imgWidth, int imgHeight);
+    QVector<TilePlan> planGreedy(const QVector<BBox> &eligible) const;
+    QVector<TilePlan> planMinCover(const QVector<BBox> &eligible) const;
+    // label của tile, chung cho Greedy và MinCover: mọi bbox chạm vào tile (kể cả bbox lớn hơn tile)
+    void assignBoxes(QVector<TilePlan> &plans) const;
+    // minVisible > 0: bỏ box còn thấy trong tile ít hơn tỉ lệ diện tích này, đếm vào dropped
+    QVector<BBox> clipToTile(const cv::Rect &roi, const QVector<BBox> &boxes,
+                             double minVisible = 0.0, int *dropped = nullptr) const;
+    cv::Rect boxRect(const BBox &b) const;
+
+    bool saveTile(const cv::Mat &tile, const TilePlan &plan); // false: ảnh hoặc label không ghi được
 
     // grouping / utils
     QVector<QVector<BBox>> groupBBoxes(const QVector<BBox> &boxes) const;
@@ -36,10 +94,21 @@ private:
     QString m_outputDir;
     QSize m_tileSize;
     QVector<BBox> m_boxes;
+    bool m_labelsLoaded {false};
+    QVector<Level> m_levels;
     int m_imgWidth {0};
     int m_imgHeight {0};
 
     double m_iouThresh {0.3}; // ngưỡng tránh tile trùng
+    Placement m_placement {Placement::Greedy};
+    Report m_report;
+
+    EncoderProfile m_profile {EncoderProfile::byName("source")};
+    EncodeStats m_encodeStats;
+    ProgressChannel *m_progress {nullptr};
+
+    TileQualityGate m_gate;
+    TileQualityGate::Stats m_gateStats;
 };
 
 #endif // IMAGETILER_H
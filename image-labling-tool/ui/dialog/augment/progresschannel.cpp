@@ -0,0 +1,159 @@
+#include "progresschannel.h"
+#include <QLocale>
+#include <algorithm>
+
+namespace {
+
+QString formatDuration(qint64 ms)
+{
+    qint64 s = ms / 1000;
+    if (s >= 3600)
+        return QString("%1:%2:%3").arg(s / 3600).arg((s / 60) % 60, 2, 10, QChar('0')).arg(s % 60, 2, 10, QChar('0'));
+    return QString("%1:%2").arg(s / 60).arg(s % 60, 2, 10, QChar('0'));
+}
+
+}
+
+qint64 ProgressChannel::nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void ProgressChannel::start(qint64 total, const QStringList &stages)
+{
+    m_total.value = total;
+    m_done.value = 0;
+    m_failed.value = 0;
+    m_bytes.value = 0;
+    for (int i = 0; i < MaxStages; ++i) {
+        m_stageCount[i].value = 0;
+        m_stageNs[i].value = 0;
+    }
+    m_stageNames = stages.mid(0, MaxStages);
+    m_finishNs = 0;
+    m_startNs = nowNs();
+}
+
+void ProgressChannel::finish()
+{
+    m_finishNs = nowNs();
+}
+
+void ProgressChannel::stageDone(int stage, qint64 ns)
+{
+    if (stage < 0 || stage >= MaxStages) return;
+    m_stageCount[stage].value.fetch_add(1, std::memory_order_relaxed);
+    m_stageNs[stage].value.fetch_add(ns, std::memory_order_relaxed);
+}
+
+ProgressChannel::Snapshot ProgressChannel::snapshot() const
+{
+    Snapshot s;
+    s.total = m_total.value.load(std::memory_order_relaxed);
+    s.done = m_done.value.load(std::memory_order_relaxed);
+    s.failed = m_failed.value.load(std::memory_order_relaxed);
+    s.bytes = m_bytes.value.load(std::memory_order_relaxed);
+
+    qint64 startNs = m_startNs.load();
+    qint64 finishNs = m_finishNs.load();
+    s.finished = finishNs != 0;
+    if (startNs != 0)
+        s.elapsedMs = ((s.finished ? finishNs : nowNs()) - startNs) / 1000000;
+
+    qint64 processed = s.processed();
+    if (s.elapsedMs > 0 && processed > 0) {
+        s.itemsPerSecond = processed * 1000.0 / s.elapsedMs;
+        s.etaMs = s.total > processed ? qint64((s.total - processed) * 1000.0 / s.itemsPerSecond) : 0;
+    }
+
+    for (int i = 0; i < m_stageNames.size(); ++i) {
+        s.stages.push_back({m_stageNames[i],
+                            m_stageCount[i].value.load(std::memory_order_relaxed),
+                            m_stageNs[i].value.load(std::memory_order_relaxed)});
+    }
+    return s;
+}
+
+int ProgressChannel::Snapshot::percent() const
+{
+    if (total <= 0) return finished ? 100 : 0;
+    return int(std::min<qint64>(100, processed() * 100 / total));
+}
+
+QString ProgressChannel::Snapshot::text() const
+{
+    QStringList parts;
+    parts << QString("%1/%2").arg(processed()).arg(total);
+    if (failed > 0)
+        parts << QString("%1 failed").arg(failed);
+    if (bytes > 0)
+        parts << QLocale().formattedDataSize(bytes);
+    if (itemsPerSecond > 0.0)
+        parts << QString("%1/s").arg(itemsPerSecond, 0, 'f', 1);
+    if (finished)
+        parts << QString("done in %1").arg(formatDuration(elapsedMs));
+    else if (etaMs >= 0)
+        parts << QString("ETA %1").arg(formatDuration(etaMs));
+
+    QStringList stageParts;
+    for (const Stage &stage : stages) {
+        if (stage.count == 0) continue;
+        stageParts << QString("%1 %2 ms").arg(stage.name).arg(stage.ns / 1e6 / stage.count, 0, 'f', 1);
+    }
+
+    QString line = parts.join(" | ");
+    if (!stageParts.isEmpty())
+        line += "  (" + stageParts.join(", ") + ")";
+    return line;
+}
+
+ProgressChannel::StageTimer::StageTimer(ProgressChannel *channel, int stage)
+    : m_channel(channel), m_stage(stage)
+{
+    if (m_channel)
+        m_start = std::chrono::steady_clock::now();
+}
+
+ProgressChannel::StageTimer::~StageTimer()
+{
+    if (!m_channel) return;
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start);
+    m_channel->stageDone(m_stage, ns.count());
+}
+
+ProgressMonitor::ProgressMonitor(ProgressChannel *channel, QObject *parent, int intervalMs)
+    : QObject(parent), m_channel(channel)
+{
+    m_timer.setInterval(std::max(10, intervalMs));
+    connect(&m_timer, &QTimer::timeout, this, &ProgressMonitor::sample);
+}
+
+void ProgressMonitor::start()
+{
+    m_reported = 0;
+    m_last = ProgressChannel::Snapshot();
+    m_timer.start();
+}
+
+void ProgressMonitor::stop()
+{
+    m_timer.stop();
+    sample();
+}
+
+void ProgressMonitor::sample()
+{
+    ProgressChannel::Snapshot s = m_channel->snapshot();
+    bool changed = s.processed() != m_last.processed() || s.total != m_last.total
+                   || s.bytes != m_last.bytes || s.finished != m_last.finished;
+    m_last = s;
+    if (!changed && s.finished) return; // vẫn phát khi đang chạy để elapsed/ETA cập nhật
+
+    emit progressed(s);
+    qint64 increment = s.processed() - m_reported;
+    if (increment > 0) {
+        m_reported = s.processed();
+        emit advanced(int(increment));
+    }
+}
@@ -0,0 +1,124 @@
+#ifndef PROGRESSCHANNEL_H
+#define PROGRESSCHANNEL_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+#include <array>
+#include <atomic>
+#include <chrono>
+
+// Kênh tiến độ dùng chung: worker chỉ cộng các bộ đếm atomic (relaxed, không lock, không signal),
+// GUI đọc snapshot theo chu kỳ cố định qua ProgressMonitor
+class ProgressChannel
+{
+public:
+    static constexpr int MaxStages = 8;
+
+    struct Stage {
+        QString name;
+        qint64 count {0};
+        qint64 ns {0};  // tổng thời gian trên mọi thread
+    };
+
+    struct Snapshot {
+        qint64 total {0};
+        qint64 done {0};
+        qint64 failed {0};
+        qint64 bytes {0};
+        qint64 elapsedMs {0};
+        double itemsPerSecond {0.0};
+        qint64 etaMs {-1};  // -1 -> chưa ước lượng được
+        bool finished {false};
+        QVector<Stage> stages;
+
+        qint64 processed() const { return done + failed; }
+        int percent() const;
+        QString text() const;
+    };
+
+    ProgressChannel() = default;
+    ProgressChannel(const ProgressChannel &) = delete;
+    ProgressChannel &operator=(const ProgressChannel &) = delete;
+
+    // Gọi trước khi worker chạy (không thread-safe)
+    void start(qint64 total, const QStringList &stages = QStringList());
+    void finish();
+
+    // Thread-safe, gọi được từ mọi worker
+    void addTotal(qint64 n) { m_total.value.fetch_add(n, std::memory_order_relaxed); }
+    void itemDone(qint64 bytes = 0)
+    {
+        m_done.value.fetch_add(1, std::memory_order_relaxed);
+        if (bytes > 0) m_bytes.value.fetch_add(bytes, std::memory_order_relaxed);
+    }
+    void itemsDone(qint64 n) { m_done.value.fetch_add(n, std::memory_order_relaxed); }
+    void itemFailed() { m_failed.value.fetch_add(1, std::memory_order_relaxed); }
+    void addBytes(qint64 bytes) { m_bytes.value.fetch_add(bytes, std::memory_order_relaxed); }
+    void stageDone(int stage, qint64 ns);
+
+    Snapshot snapshot() const;
+
+    // Đo thời gian 1 stage trong scope; channel null -> không làm gì
+    class StageTimer
+    {
+    public:
+        StageTimer(ProgressChannel *channel, int stage);
+        ~StageTimer();
+        StageTimer(const StageTimer &) = delete;
+        StageTimer &operator=(const StageTimer &) = delete;
+
+    private:
+        ProgressChannel *m_channel;
+        int m_stage;
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+private:
+    // mỗi bộ đếm một cache line để các core không tranh nhau cùng line
+    struct alignas(64) Counter {
+        std::atomic<qint64> value {0};
+    };
+
+    static qint64 nowNs();
+
+    Counter m_total;
+    Counter m_done;
+    Counter m_failed;
+    Counter m_bytes;
+    std::array<Counter, MaxStages> m_stageCount;
+    std::array<Counter, MaxStages> m_stageNs;
+    QStringList m_stageNames;
+    std::atomic<qint64> m_startNs {0};
+    std::atomic<qint64> m_finishNs {0};
+};
+
+// Lấy mẫu ProgressChannel trên GUI thread với tần số cố định (thay cho 1 signal mỗi item)
+class ProgressMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ProgressMonitor(ProgressChannel *channel, QObject *parent = nullptr, int intervalMs = 100);
+
+    void start();
+    void stop();   // lấy mẫu lần cuối rồi dừng timer
+    void sample();
+
+    const ProgressChannel::Snapshot &last() const { return m_last; }
+
+signals:
+    void progressed(const ProgressChannel::Snapshot &snapshot);
+    // số item (done + failed) tăng thêm kể từ lần lấy mẫu trước, cho các slot kiểu updateProgress(int)
+    void advanced(int increment);
+
+private:
+    ProgressChannel *m_channel;
+    QTimer m_timer;
+    ProgressChannel::Snapshot m_last;
+    qint64 m_reported {0};
+};
+
+#endif // PROGRESSCHANNEL_H
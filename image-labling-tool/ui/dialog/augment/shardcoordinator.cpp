@@ -0,0 +1,525 @@
+#include "shardcoordinator.h"
+#include "datasetscanner.h"
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QSaveFile>
+#include <QSysInfo>
+#include <QThread>
+#include <QDebug>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+const char *kPlanKind = "augment-shards";
+const int kPlanVersion = 2;
+const char *kPlanFile = "plan.jsonl";
+
+QByteArray readAll(const QString &path)
+{
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+qint64 mtimeOf(const QFileInfo &info)
+{
+    return info.exists() ? info.lastModified().toMSecsSinceEpoch() : -1;
+}
+
+// mỗi job 1 dòng JSON, đường dẫn tương đối theo thư mục điều phối;
+// size/mtime của ảnh + label nằm trong fingerprint -> sửa ảnh/label rồi Generate lại ra plan mới
+QByteArray encodeJobs(const QVector<AugmentRunner::Job> &jobs, const QDir &base)
+{
+    QByteArray out;
+    for (const auto &job : jobs) {
+        QFileInfo image(job.imagePath);
+        QFileInfo label(job.labelPath);
+        out += QJsonDocument(QJsonArray{base.relativeFilePath(job.imagePath),
+                                        job.labelPath.isEmpty() ? QString() : base.relativeFilePath(job.labelPath),
+                                        job.variants,
+                                        image.size(),
+                                        mtimeOf(image),
+                                        job.labelPath.isEmpty() ? qint64(-1) : mtimeOf(label)})
+                   .toJson(QJsonDocument::Compact);
+        out += '\n';
+    }
+    return out;
+}
+
+QString fingerprint(const ShardCoordinator::Plan &plan, const QString &outputDir, const QString &keyBase,
+                    const QByteArray &jobLines)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QString("%1\n%2\n%3\n%4\n%5\n%6\n")
+                     .arg(plan.policy)
+                     .arg(plan.seed, 0, 16)
+                     .arg(plan.encoderProfile, outputDir)
+                     .arg(plan.shardSize)
+                     .arg(keyBase)
+                     .toUtf8());
+    hash.addData(jobLines);
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+QString headerFingerprint(const QString &planPath)
+{
+    QFile file(planPath);
+    if (!file.open(QIODevice::ReadOnly)) return QString();
+    return QJsonDocument::fromJson(file.readLine()).object()["fingerprint"].toString();
+}
+
+}
+
+int ShardCoordinator::Plan::shardCount() const
+{
+    return shardSize > 0 ? (jobs.size() + shardSize - 1) / shardSize : 0;
+}
+
+QVector<AugmentRunner::Job> ShardCoordinator::Plan::shardJobs(int shard) const
+{
+    return jobs.mid(shard * shardSize, shardSize);
+}
+
+ShardCoordinator::ShardCoordinator(const QString &dir)
+    : m_dir(QDir::cleanPath(QDir(dir).absolutePath()))
+{
+    // host + pid + số ngẫu nhiên: phân biệt cả nhiều coordinator trong cùng 1 process
+    m_owner = QString("%1-%2-%3")
+                  .arg(QSysInfo::machineHostName())
+                  .arg(QCoreApplication::applicationPid())
+                  .arg(QRandomGenerator::global()->generate(), 8, 16, QChar('0'));
+}
+
+QString ShardCoordinator::defaultDir(const QString &imageDir)
+{
+    return QDir(imageDir).filePath(".augment_shards");
+}
+
+void ShardCoordinator::setLeaseTimeout(int ms) {
+    m_leaseTimeoutMs = ms;
+}
+
+void ShardCoordinator::setHeartbeatInterval(int ms) {
+    m_heartbeatIntervalMs = ms;
+}
+
+void ShardCoordinator::setPollInterval(int ms) {
+    m_pollIntervalMs = ms;
+}
+
+void ShardCoordinator::setMaxThreads(int n) {
+    m_maxThreads = n;
+}
+
+void ShardCoordinator::setProgress(ProgressChannel *channel) {
+    m_progress = channel;
+}
+
+QString ShardCoordinator::planPath() const
+{
+    return m_dir + "/" + kPlanFile;
+}
+
+QString ShardCoordinator::leasePath(int shard) const
+{
+    return QString("%1/shard-%2.lease").arg(m_dir).arg(shard);
+}
+
+QString ShardCoordinator::donePath(int shard) const
+{
+    return QString("%1/shard-%2.done").arg(m_dir).arg(shard);
+}
+
+QSet<QString> ShardCoordinator::listNames() const
+{
+    // 1 lần đọc thư mục cho mỗi vòng quét thay vì stat từng file lease/done
+    QSet<QString> names;
+    for (const auto &e : DatasetScanner::listDirectory(m_dir))
+        names.insert(e.name);
+    return names;
+}
+
+bool ShardCoordinator::publish(const Plan &plan, QString *error)
+{
+    if (!QDir().mkpath(m_dir)) {
+        if (error) *error = QString("Cannot create shard directory: %1").arg(m_dir);
+        return false;
+    }
+
+    QDir base(m_dir);
+    QString outputDir = plan.outputDir.isEmpty() ? QString() : base.relativeFilePath(plan.outputDir);
+    QString keyBase = plan.keyBase.isEmpty() ? QString() : base.relativeFilePath(plan.keyBase);
+    QByteArray jobLines = encodeJobs(plan.jobs, base);
+    QString print = fingerprint(plan, outputDir, keyBase, jobLines);
+
+    if (QFile::exists(planPath())) {
+        // cùng plan -> tham gia; đã xong hết thì caller xem remainingShards() để báo không còn gì chạy
+        if (headerFingerprint(planPath()) == print)
+            return true;
+
+        Plan existing;
+        int remaining = remainingShards(&existing);
+        if (remaining > 0) {
+            if (error) *error = QString("Another sharded run is still in progress in %1 (%2/%3 shards done)")
+                                    .arg(m_dir).arg(existing.shardCount() - remaining).arg(existing.shardCount());
+            return false;
+        }
+
+        // lần chạy trước đã xong -> dọn để bắt đầu plan mới
+        for (const QString &name : listNames()) {
+            if (name == kPlanFile || name.startsWith("shard-") || name.startsWith("clock-")
+                || (name.startsWith("plan-") && name.endsWith(".tmp")))
+                base.remove(name);
+        }
+    }
+
+    QJsonObject header;
+    header["plan"] = kPlanKind;
+    header["version"] = kPlanVersion;
+    header["policy"] = plan.policy;
+    header["seed"] = QString::number(plan.seed, 16);
+    header["profile"] = plan.encoderProfile;
+    header["output"] = outputDir;
+    header["keyBase"] = keyBase;
+    header["shardSize"] = plan.shardSize;
+    header["jobs"] = plan.jobs.size();
+    header["fingerprint"] = print;
+
+    // ghi file tạm riêng rồi rename không ghi đè (renameat2 NOREPLACE / link): 2 process cùng publish chỉ 1 thắng
+    QString tmpPath = base.filePath(QString("plan-%1.tmp").arg(m_owner));
+    QFile tmp(tmpPath);
+    if (!tmp.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (error) *error = QString("Cannot write shard plan: %1").arg(tmpPath);
+        return false;
+    }
+    tmp.write(QJsonDocument(header).toJson(QJsonDocument::Compact));
+    tmp.write("\n");
+    tmp.write(jobLines);
+    tmp.close();
+
+    if (!QFile::rename(tmpPath, planPath())) {
+        QFile::remove(tmpPath);
+        if (headerFingerprint(planPath()) != print) {
+            if (error) *error = QString("Another shard plan was published in %1").arg(m_dir);
+            return false;
+        }
+    }
+    qDebug() << "ShardCoordinator: plan" << plan.jobs.size() << "jobs," << plan.shardCount() << "shards ->" << m_dir;
+    return true;
+}
+
+bool ShardCoordinator::load(Plan *plan, QString *error) const
+{
+    QFile file(planPath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) *error = QString("No shard plan in %1").arg(m_dir);
+        return false;
+    }
+
+    QJsonObject header = QJsonDocument::fromJson(file.readLine()).object();
+    if (header["plan"].toString() != kPlanKind) {
+        if (error) *error = QString("%1 is not a shard plan").arg(planPath());
+        return false;
+    }
+    if (header["version"].toInt() > kPlanVersion) {
+        if (error) *error = QString("Unsupported shard plan version %1").arg(header["version"].toInt());
+        return false;
+    }
+
+    QDir base(m_dir);
+    Plan p;
+    p.policy = header["policy"].toString();
+    p.seed = header["seed"].toString().toULongLong(nullptr, 16);
+    p.encoderProfile = header["profile"].toString();
+    QString output = header["output"].toString();
+    p.outputDir = output.isEmpty() ? QString() : QDir::cleanPath(base.absoluteFilePath(output));
+    QString keyBase = header["keyBase"].toString(); // v1: không có -> key là tên file
+    p.keyBase = keyBase.isEmpty() ? QString() : QDir::cleanPath(base.absoluteFilePath(keyBase));
+    p.shardSize = header["shardSize"].toInt();
+    p.jobs.reserve(header["jobs"].toInt());
+
+    while (!file.atEnd()) {
+        QByteArray line = file.readLine().trimmed();
+        if (line.isEmpty()) continue;
+        QJsonArray job = QJsonDocument::fromJson(line).array();
+        if (job.size() < 3) { // v1 không có size/mtime
+            if (error) *error = QString("%1: bad job line").arg(planPath());
+            return false;
+        }
+        QString label = job[1].toString();
+        p.jobs.push_back({QDir::cleanPath(base.absoluteFilePath(job[0].toString())),
+                          label.isEmpty() ? QString() : QDir::cleanPath(base.absoluteFilePath(label)),
+                          job[2].toInt()});
+    }
+    if (p.jobs.size() != header["jobs"].toInt() || p.shardSize <= 0) {
+        if (error) *error = QString("%1 is incomplete").arg(planPath());
+        return false;
+    }
+
+    *plan = p;
+    return true;
+}
+
+int ShardCoordinator::remainingShards(Plan *plan) const
+{
+    Plan p;
+    if (!load(&p))
+        return 0;
+
+    QSet<QString> names = listNames();
+    int remaining = 0;
+    for (int i = 0; i < p.shardCount(); ++i)
+        remaining += !names.contains(QFileInfo(donePath(i)).fileName());
+    if (plan) *plan = p;
+    return remaining;
+}
+
+qint64 ShardCoordinator::fsNowMs()
+{
+    // so tuổi lease theo đồng hồ của file server (mtime của file vừa ghi), không theo giờ máy -> chịu được lệch giờ giữa các máy
+    QString probe = m_dir + "/clock-" + m_owner;
+    QFile file(probe);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        file.write(m_owner.toUtf8());
+        file.close();
+    }
+    QFileInfo info(probe);
+    return info.exists() ? info.lastModified().toMSecsSinceEpoch() : QDateTime::currentMSecsSinceEpoch();
+}
+
+void ShardCoordinator::removeLeftovers(qint64 nowMs)
+{
+    // file của process đã chết giữa chừng: clock-<owner>, plan-<owner>.tmp, shard-N.lease.stale-<owner>.
+    // Process còn sống ghi lại các file này liên tục nên chỉ xoá file cũ hơn thời hạn lease
+    QDir base(m_dir);
+    for (const QString &name : listNames()) {
+        bool leftover = name.startsWith("clock-") || name.contains(".stale-")
+                        || (name.startsWith("plan-") && name.endsWith(".tmp"));
+        if (!leftover || name == QString("clock-%1").arg(m_owner)) continue;
+        QFileInfo info(base.filePath(name));
+        if (info.exists() && nowMs - info.lastModified().toMSecsSinceEpoch() >= m_leaseTimeoutMs)
+            base.remove(name);
+    }
+}
+
+void ShardCoordinator::writeLease(QFile &file, int shard)
+{
+    QJsonObject lease;
+    lease["owner"] = m_owner;
+    lease["shard"] = shard;
+    lease["seq"] = ++m_heartbeatSeq;
+    file.write(QJsonDocument(lease).toJson(QJsonDocument::Compact));
+    file.flush();
+}
+
+bool ShardCoordinator::heartbeat(int shard)
+{
+    // ghi lại nội dung -> mtime mới; lease không còn là của mình thì báo mất
+    QFile file(leasePath(shard));
+    if (!file.open(QIODevice::ReadWrite | QIODevice::ExistingOnly)) // đã bị rename đi thì không tạo lại
+        return false;
+    if (QJsonDocument::fromJson(file.readAll()).object()["owner"].toString() != m_owner)
+        return false;
+    file.seek(0);
+    file.resize(0);
+    writeLease(file, shard);
+    return true;
+}
+
+ShardCoordinator::Claim ShardCoordinator::tryClaim(int shard, const QSet<QString> &names, qint64 nowMs)
+{
+    QString path = leasePath(shard);
+    if (names.contains(QFileInfo(donePath(shard)).fileName()))
+        return Claim::Done;
+
+    QFile lease(path);
+    if (!names.contains(QFileInfo(path).fileName())) {
+        // O_CREAT | O_EXCL: nhiều process cùng tạo thì chỉ 1 process thành công
+        if (!lease.open(QIODevice::WriteOnly | QIODevice::NewOnly))
+            return Claim::Busy;
+        writeLease(lease, shard);
+        return Claim::Claimed;
+    }
+
+    QFileInfo info(path);
+    if (!info.exists() || nowMs - info.lastModified().toMSecsSinceEpoch() < m_leaseTimeoutMs)
+        return Claim::Busy;
+
+    // lease hết hạn: rename sang tên riêng (chỉ 1 process rename được) rồi mới tạo lease mới
+    QByteArray expired = readAll(path);
+    QString stale = QString("%1.stale-%2").arg(path, m_owner);
+    if (!QFile::rename(path, stale))
+        return Claim::Busy;
+
+    // giữa lúc xem và lúc rename, chủ cũ có thể vừa heartbeat hoặc process khác vừa giành lại -> trả về.
+    // rename không đổi mtime nên stat lại file đã rename cho biết lease còn sống hay không
+    QFileInfo staleInfo(stale);
+    if (!staleInfo.exists() || nowMs - staleInfo.lastModified().toMSecsSinceEpoch() < m_leaseTimeoutMs
+        || readAll(stale) != expired) {
+        if (!QFile::rename(stale, path))
+            QFile::remove(stale); // chủ lease sẽ thấy mất lease ở heartbeat kế tiếp
+        return Claim::Busy;
+    }
+    QFile::remove(stale);
+
+    if (!lease.open(QIODevice::WriteOnly | QIODevice::NewOnly))
+        return Claim::Busy;
+    writeLease(lease, shard);
+    qWarning() << "ShardCoordinator: reclaimed expired lease of shard" << shard << ":" << expired;
+    return Claim::Reclaimed;
+}
+
+void ShardCoordinator::markDone(int shard, const AugmentRunner::Stats &stats)
+{
+    QJsonObject done;
+    done["owner"] = m_owner;
+    done["sources"] = stats.sources;
+    done["written"] = stats.written;
+    done["unchanged"] = stats.unchanged;
+    done["failed"] = stats.failed;
+    done["bytes"] = double(stats.bytes);
+    done["elapsedMs"] = double(stats.elapsedMs);
+
+    QSaveFile file(donePath(shard));
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(QJsonDocument(done).toJson(QJsonDocument::Compact));
+        if (file.commit())
+            return;
+    }
+    qWarning() << "ShardCoordinator: cannot write" << donePath(shard);
+}
+
+ShardCoordinator::Report ShardCoordinator::runWorker(QString *error)
+{
+    Report report;
+    QElapsedTimer timer;
+    timer.start();
+
+    Plan plan;
+    if (!load(&plan, error))
+        return report;
+
+    QString policyError;
+    AugmentPolicy policy = AugmentPolicy::fromString(plan.policy, &policyError);
+    if (policy.isEmpty()) {
+        if (error) *error = policyError;
+        return report;
+    }
+    policy.setSeed(plan.seed);
+
+    AugmentRunner runner;
+    runner.setPolicy(policy);
+    runner.setEncoderProfile(EncoderProfile::byName(plan.encoderProfile));
+    runner.setOutputDir(plan.outputDir);
+    runner.setKeyBase(plan.keyBase);
+    runner.setMaxThreads(m_maxThreads);
+    runner.setProgress(m_progress);
+
+    report.shards = plan.shardCount();
+    // mỗi process bắt đầu quét từ 1 vị trí khác -> ít khi tranh cùng 1 shard
+    int start = report.shards > 0 ? int(qHash(m_owner) % uint(report.shards)) : 0;
+    QSet<int> failed;
+    removeLeftovers(fsNowMs());
+
+    for (;;) {
+        QSet<QString> names = listNames();
+        qint64 now = fsNowMs();
+
+        int shard = -1;
+        int settled = 0;
+        for (int i = 0; i < report.shards && shard < 0; ++i) {
+            int candidate = (start + i) % report.shards;
+            if (failed.contains(candidate)) { // đã lỗi ở lượt này: không chạy lại ngay, để lượt sau thử lại
+                settled++;
+                continue;
+            }
+            switch (tryClaim(candidate, names, now)) {
+            case Claim::Done:
+                settled++;
+                break;
+            case Claim::Reclaimed:
+                report.reclaimed++;
+                shard = candidate;
+                break;
+            case Claim::Claimed:
+                shard = candidate;
+                break;
+            case Claim::Busy:
+                break;
+            }
+        }
+
+        if (shard < 0) {
+            if (settled == report.shards) break;
+            QThread::msleep(ulong(m_pollIntervalMs)); // còn shard đang có chủ: đợi xong hoặc hết hạn
+            continue;
+        }
+
+        // heartbeat trên thread riêng trong lúc runner chạy shard
+        std::mutex mutex;
+        std::condition_variable wake;
+        bool stop = false;
+        std::atomic<bool> lost {false};
+        std::thread beat([&]() {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!wake.wait_for(lock, std::chrono::milliseconds(m_heartbeatIntervalMs), [&] { return stop; })) {
+                if (!heartbeat(shard))
+                    lost = true;
+            }
+        });
+
+        AugmentRunner::Stats stats = runner.run(plan.shardJobs(shard));
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        wake.notify_one();
+        beat.join();
+
+        // done trước, xoá lease sau: không lúc nào shard trông như chưa ai làm.
+        // Có ảnh lỗi thì không ghi done, chỉ trả lease: shard vẫn còn trong remainingShards() để chạy lại
+        if (stats.failed == 0) {
+            markDone(shard, stats);
+        } else {
+            failed.insert(shard);
+            report.failedShards++;
+            qWarning() << "ShardCoordinator: shard" << shard << "had" << stats.failed
+                       << "failed images, left for another pass";
+        }
+        if (lost) {
+            report.lostLeases++;
+            qWarning() << "ShardCoordinator: lost lease of shard" << shard << "while running";
+        } else {
+            QFile::remove(leasePath(shard));
+        }
+
+        report.processed++;
+        report.stats.sources += stats.sources;
+        report.stats.written += stats.written;
+        report.stats.unchanged += stats.unchanged;
+        report.stats.failed += stats.failed;
+        report.stats.bytes += stats.bytes;
+        report.stats.encodeMs += stats.encodeMs;
+    }
+
+    QFile::remove(m_dir + "/clock-" + m_owner);
+    report.elapsedMs = timer.elapsed();
+    report.stats.elapsedMs = report.elapsedMs;
+    qDebug() << "ShardCoordinator:" << m_owner << "ran" << report.processed << "of" << report.shards
+             << "shards (" << report.reclaimed << "reclaimed," << report.lostLeases << "lost,"
+             << report.failedShards << "failed ) in"
+             << report.elapsedMs << "ms";
+    return report;
+}
@@ -0,0 +1,92 @@
+#ifndef SHARDCOORDINATOR_H
+#define SHARDCOORDINATOR_H
+
+#include <QFile>
+#include <QSet>
+#include <QString>
+#include <QVector>
+#include "augmentrunner.h"
+#include "progresschannel.h"
+
+// Chạy 1 lần Random Policy augmentation trên nhiều process/máy dùng chung filesystem.
+// Danh sách job được chia thành shard cố định; process giành shard bằng file lease tạo nguyên tử (O_EXCL),
+// giữ lease bằng heartbeat, lease quá hạn (process chết) được process khác giành lại.
+// Ảnh của mỗi variant chỉ phụ thuộc seed + đường dẫn ảnh nguồn tương đối theo thư mục quét (keyBase)
+// nên output gộp giống hệt khi chạy 1 process, dù các máy mount share ở chỗ khác nhau.
+class ShardCoordinator
+{
+public:
+    struct Plan {
+        QString policy;          // AugmentPolicy::toString()
+        quint64 seed {0};
+        QString encoderProfile;  // EncoderProfile::byName()
+        QString outputDir;       // rỗng -> cạnh ảnh gốc
+        QString keyBase;         // AugmentRunner::setKeyBase(); rỗng -> key là tên file
+        int shardSize {256};     // số ảnh nguồn mỗi shard
+        QVector<AugmentRunner::Job> jobs;
+
+        int shardCount() const;
+        QVector<AugmentRunner::Job> shardJobs(int shard) const;
+    };
+
+    struct Report {
+        int shards {0};
+        int processed {0};   // số shard process này đã chạy
+        int reclaimed {0};   // trong đó giành lại từ lease hết hạn
+        int lostLeases {0};  // lease bị giành mất khi đang chạy: shard bị chạy 2 lần, kết quả vẫn như nhau
+        int failedShards {0}; // có ảnh lỗi: không ghi done, trả lease để lần chạy sau làm lại
+        AugmentRunner::Stats stats;
+        qint64 elapsedMs {0};
+    };
+
+    explicit ShardCoordinator(const QString &dir);
+
+    // Thư mục điều phối mặc định cho 1 thư mục ảnh (ẩn -> DatasetScanner không quét vào)
+    static QString defaultDir(const QString &imageDir);
+
+    const QString &dir() const { return m_dir; }
+    const QString &ownerId() const { return m_owner; }
+
+    // Process đầu tiên ghi plan; plan đã có thì phải giống hệt, hoặc đã chạy xong hết thì được thay.
+    // Đường dẫn lưu tương đối theo thư mục điều phối -> các máy mount share ở chỗ khác nhau vẫn dùng được
+    bool publish(const Plan &plan, QString *error = nullptr);
+    bool load(Plan *plan, QString *error = nullptr) const;
+    // Số shard chưa có file done (không có plan -> 0)
+    int remainingShards(Plan *plan = nullptr) const;
+
+    // heartbeat phải nhỏ hơn nhiều so với timeout (mặc định 10 s / 60 s)
+    void setLeaseTimeout(int ms);
+    void setHeartbeatInterval(int ms);
+    void setPollInterval(int ms);   // chờ giữa 2 lần quét khi mọi shard còn lại đều đang có chủ
+    void setMaxThreads(int n);
+    void setProgress(ProgressChannel *channel);
+
+    // Giành và chạy shard cho tới khi mọi shard có file done hoặc đã lỗi ở lượt này; bao nhiêu process gọi cùng lúc cũng được
+    Report runWorker(QString *error = nullptr);
+
+private:
+    enum class Claim { Claimed, Reclaimed, Busy, Done };
+
+    QString planPath() const;
+    QString leasePath(int shard) const;
+    QString donePath(int shard) const;
+    QSet<QString> listNames() const;
+
+    Claim tryClaim(int shard, const QSet<QString> &names, qint64 nowMs);
+    void writeLease(QFile &file, int shard);
+    bool heartbeat(int shard);
+    void markDone(int shard, const AugmentRunner::Stats &stats);
+    qint64 fsNowMs();
+    void removeLeftovers(qint64 nowMs);
+
+    QString m_dir;
+    QString m_owner;
+    qint64 m_heartbeatSeq {0};
+    int m_leaseTimeoutMs {60000};
+    int m_heartbeatIntervalMs {10000};
+    int m_pollIntervalMs {2000};
+    int m_maxThreads {0};
+    ProgressChannel *m_progress {nullptr};
+};
+
+#endif // SHARDCOORDINATOR_H
@@ -0,0 +1,282 @@
+#include "slicedinference.h"
+#include "spatialgrid.h"
+#include <QtConcurrent/QtConcurrent>
+#include <QFuture>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <list>
+#include <numeric>
+
+namespace {
+
+float iou(const cv::Rect2f &a, const cv::Rect2f &b)
+{
+    float inter = (a & b).area();
+    float uni = a.area() + b.area() - inter;
+    return uni > 0.0f ? inter / uni : 0.0f;
+}
+
+cv::Rect gridRect(const cv::Rect2f &r)
+{
+    return cv::Rect(int(std::floor(r.x)), int(std::floor(r.y)),
+                    std::max(1, int(std::ceil(r.width))), std::max(1, int(std::ceil(r.height))));
+}
+
+// Vị trí tile theo 1 trục: bước = tile * (1 - overlap), tile cuối dính sát biên
+QVector<int> axisStarts(int length, int tile, double overlap)
+{
+    QVector<int> starts;
+    if (tile >= length) {
+        starts.push_back(0);
+        return starts;
+    }
+    int step = std::max(1, int(tile * (1.0 - overlap)));
+    for (int s = 0; ; s += step) {
+        if (s + tile >= length) {
+            starts.push_back(length - tile);
+            break;
+        }
+        starts.push_back(s);
+    }
+    return starts;
+}
+
+struct PendingImage {
+    QString path;
+    cv::Mat img;
+    int tilesLeft {0};
+    QVector<Detection> detections;
+};
+
+struct TileRef {
+    PendingImage *owner;
+    cv::Rect roi;
+};
+
+}
+
+QStringList SlicedInference::progressStages()
+{
+    return {"decode", "infer", "merge"};
+}
+
+QVector<cv::Rect> SlicedInference::sliceGrid(int imgWidth, int imgHeight, const QSize &tileSize, double overlap)
+{
+    overlap = std::clamp(overlap, 0.0, 0.9);
+    int tileW = std::min(tileSize.width(), imgWidth);
+    int tileH = std::min(tileSize.height(), imgHeight);
+
+    QVector<cv::Rect> rois;
+    for (int y : axisStarts(imgHeight, tileH, overlap))
+        for (int x : axisStarts(imgWidth, tileW, overlap))
+            rois.push_back(cv::Rect(x, y, tileW, tileH));
+    return rois;
+}
+
+QVector<Detection> SlicedInference::merge(const QVector<Detection> &detections, Merge method,
+                                          double iouThreshold, int cellSize)
+{
+    // xét theo điểm giảm dần; lưới không gian riêng cho từng class để chỉ so với box lân cận
+    QVector<int> order(detections.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&detections](int a, int b) {
+        return detections[a].score > detections[b].score;
+    });
+
+    QHash<int, SpatialGrid> grids;
+    QVector<Detection> kept;
+    QVector<double> weightSum;            // WBF: tổng score của cụm
+    QVector<cv::Rect2f> weightedBox;      // WBF: tổng box * score
+    QVector<int> members;
+
+    for (int idx : order) {
+        const Detection &d = detections[idx];
+        auto git = grids.find(d.cls);
+        if (git == grids.end())
+            git = grids.insert(d.cls, SpatialGrid(cellSize, cellSize));
+
+        int match = -1;
+        float bestIou = float(iouThreshold);
+        for (int k : git->query(gridRect(d.box))) {
+            float v = iou(kept[k].box, d.box);
+            if (v > bestIou) {
+                bestIou = v;
+                match = k;
+            }
+        }
+
+        if (match < 0) {
+            git->insert(kept.size(), gridRect(d.box));
+            kept.push_back(d);
+            weightSum.push_back(d.score);
+            weightedBox.push_back(cv::Rect2f(d.box.x * d.score, d.box.y * d.score,
+                                             d.box.width * d.score, d.box.height * d.score));
+            members.push_back(1);
+            continue;
+        }
+
+        if (method == Merge::Nms)
+            continue; // bị box điểm cao hơn che
+
+        // WBF: cộng dồn box theo trọng số score
+        weightSum[match] += d.score;
+        weightedBox[match].x += d.box.x * d.score;
+        weightedBox[match].y += d.box.y * d.score;
+        weightedBox[match].width += d.box.width * d.score;
+        weightedBox[match].height += d.box.height * d.score;
+        members[match]++;
+
+        float w = float(weightSum[match]);
+        kept[match].box = cv::Rect2f(weightedBox[match].x / w, weightedBox[match].y / w,
+                                     weightedBox[match].width / w, weightedBox[match].height / w);
+        kept[match].score = w / members[match];
+    }
+    return kept;
+}
+
+QVector<BBox> SlicedInference::toYolo(const QVector<Detection> &detections, int imgWidth, int imgHeight)
+{
+    QVector<BBox> boxes;
+    cv::Rect2f imageRect(0.0f, 0.0f, float(imgWidth), float(imgHeight));
+    for (const auto &d : detections) {
+        cv::Rect2f r = d.box & imageRect;
+        if (r.width <= 0.0f || r.height <= 0.0f) continue;
+        boxes.push_back({d.cls,
+                         (r.x + r.width / 2.0f) / imgWidth,
+                         (r.y + r.height / 2.0f) / imgHeight,
+                         r.width / imgWidth,
+                         r.height / imgHeight});
+    }
+    return boxes;
+}
+
+QVector<Detection> SlicedInference::detect(const cv::Mat &img, Detector &detector, double minimumScore) const
+{
+    QVector<cv::Rect> rois = sliceGrid(img.cols, img.rows, m_options.tileSize, m_options.overlap);
+    if (m_options.fullImagePass && rois.size() > 1)
+        rois.push_back(cv::Rect(0, 0, img.cols, img.rows));
+
+    QVector<Detection> all;
+    int batchSize = std::max(1, m_options.batchSize);
+    for (int start = 0; start < rois.size(); start += batchSize) {
+        int end = std::min(int(rois.size()), start + batchSize);
+        std::vector<cv::Mat> batch;
+        for (int i = start; i < end; ++i)
+            batch.push_back(img(rois[i]));
+
+        QVector<QVector<Detection>> results = detector.detectBatch(batch, minimumScore);
+        for (int i = start; i < end && i - start < results.size(); ++i) {
+            for (Detection d : results[i - start]) {
+                d.box.x += rois[i].x; // đưa về toạ độ ảnh gốc
+                d.box.y += rois[i].y;
+                all.push_back(d);
+            }
+        }
+    }
+
+    int cellSize = std::max(64, std::min(m_options.tileSize.width(), m_options.tileSize.height()) / 4);
+    return merge(all, m_options.merge, m_options.iouThreshold, cellSize);
+}
+
+int SlicedInference::labelImages(const QStringList &imagePaths, Detector &detector, double minimumScore,
+                                 ProgressChannel *progress, const QHash<QString, QString> *labelPaths) const
+{
+    int batchSize = std::max(1, m_options.batchSize);
+    int cellSize = std::max(64, std::min(m_options.tileSize.width(), m_options.tileSize.height()) / 4);
+    int labelled = 0;
+
+    std::list<PendingImage> pending; // list: con trỏ owner trong batch không bị đổi khi thêm ảnh
+    std::vector<TileRef> batch;
+
+    auto finishImages = [&]() {
+        for (auto it = pending.begin(); it != pending.end(); ) {
+            if (it->tilesLeft > 0) {
+                ++it;
+                continue;
+            }
+            QVector<Detection> merged;
+            {
+                ProgressChannel::StageTimer t(progress, StageMerge);
+                merged = merge(it->detections, m_options.merge, m_options.iouThreshold, cellSize);
+            }
+            QString labelPath = labelPaths ? labelPaths->value(it->path) : QString();
+            if (labelPath.isEmpty())
+                labelPath = YoloLabel::labelPathFor(it->path);
+            if (YoloLabel::write(labelPath, toYolo(merged, it->img.cols, it->img.rows))) {
+                labelled++;
+                if (progress) progress->itemDone();
+            } else if (progress) {
+                progress->itemFailed();
+            }
+            it = pending.erase(it);
+        }
+    };
+
+    auto flush = [&]() {
+        if (batch.empty()) return;
+        std::vector<cv::Mat> images;
+        images.reserve(batch.size());
+        for (const auto &t : batch)
+            images.push_back(t.owner->img(t.roi));
+
+        QVector<QVector<Detection>> results;
+        {
+            ProgressChannel::StageTimer t(progress, StageInfer);
+            results = detector.detectBatch(images, minimumScore);
+        }
+        if (results.size() != int(batch.size()))
+            qWarning() << "SlicedInference: detector returned" << results.size() << "results for" << batch.size() << "tiles";
+
+        for (int i = 0; i < int(batch.size()); ++i) {
+            TileRef &t = batch[i];
+            if (i < results.size()) {
+                for (Detection d : results[i]) {
+                    d.box.x += t.roi.x;
+                    d.box.y += t.roi.y;
+                    t.owner->detections.push_back(d);
+                }
+            }
+            t.owner->tilesLeft--;
+        }
+        batch.clear();
+        finishImages();
+    };
+
+    // decode ảnh kế tiếp song song với lúc model chạy
+    auto decode = [progress](const QString &path) {
+        ProgressChannel::StageTimer t(progress, StageDecode);
+        return cv::imread(path.toStdString());
+    };
+    QFuture<cv::Mat> next;
+    if (!imagePaths.isEmpty())
+        next = QtConcurrent::run(decode, imagePaths.first());
+
+    for (int i = 0; i < imagePaths.size(); ++i) {
+        cv::Mat img = next.result();
+        if (i + 1 < imagePaths.size())
+            next = QtConcurrent::run(decode, imagePaths[i + 1]);
+
+        if (img.empty()) {
+            qWarning() << "Cannot read image:" << imagePaths[i];
+            if (progress) progress->itemFailed();
+            continue;
+        }
+
+        QVector<cv::Rect> rois = sliceGrid(img.cols, img.rows, m_options.tileSize, m_options.overlap);
+        if (m_options.fullImagePass && rois.size() > 1)
+            rois.push_back(cv::Rect(0, 0, img.cols, img.rows));
+
+        pending.push_back({imagePaths[i], img, int(rois.size()), {}});
+        PendingImage *owner = &pending.back();
+        for (const auto &roi : rois) {
+            batch.push_back({owner, roi});
+            if (int(batch.size()) >= batchSize)
+                flush();
+        }
+    }
+    flush();
+
+    qDebug() << "SlicedInference: labelled" << labelled << "of" << imagePaths.size() << "images";
+    return labelled;
+}
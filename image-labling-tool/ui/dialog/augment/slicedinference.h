@@ -0,0 +1,73 @@
+#ifndef SLICEDINFERENCE_H
+#define SLICEDINFERENCE_H
+
+#include <opencv2/opencv.hpp>
+#include <QHash>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <vector>
+#include "yololabel.h"
+#include "progresschannel.h"
+
+struct Detection {
+    int cls;
+    float score;
+    cv::Rect2f box; // pixel, toạ độ theo ảnh/tile được đưa vào detector
+};
+
+// Giao diện model: nhận 1 batch ảnh (tile), trả về detection cho từng ảnh theo đúng thứ tự.
+// Model thật: DnnDetector (ONNX qua cv::dnn); test dùng StubDetector trong tests/.
+class Detector
+{
+public:
+    virtual ~Detector() = default;
+    virtual QVector<QVector<Detection>> detectBatch(const std::vector<cv::Mat> &images,
+                                                    double minimumScore) = 0;
+};
+
+// Auto-label kiểu cắt lát: chia ảnh lớn thành tile trong bộ nhớ, chạy model theo batch,
+// đưa detection về toạ độ ảnh gốc rồi gộp bằng NMS/WBF theo từng class
+class SlicedInference
+{
+public:
+    enum class Merge { Nms, Wbf };
+
+    struct Options {
+        QSize tileSize {640, 640};
+        double overlap {0.2};      // tỉ lệ chồng lấn giữa 2 tile kề nhau
+        int batchSize {8};
+        bool fullImagePass {true}; // thêm 1 lượt trên toàn ảnh cho object lớn hơn tile
+        Merge merge {Merge::Nms};
+        double iouThreshold {0.5};
+    };
+
+    enum ProgressStage { StageDecode, StageInfer, StageMerge };
+    static QStringList progressStages();
+
+    SlicedInference() = default;
+    explicit SlicedInference(const Options &options) : m_options(options) { }
+
+    void setOptions(const Options &options) { m_options = options; }
+    const Options &options() const { return m_options; }
+
+    static QVector<cv::Rect> sliceGrid(int imgWidth, int imgHeight, const QSize &tileSize, double overlap);
+    static QVector<Detection> merge(const QVector<Detection> &detections, Merge method,
+                                    double iouThreshold, int cellSize);
+    static QVector<BBox> toYolo(const QVector<Detection> &detections, int imgWidth, int imgHeight);
+
+    QVector<Detection> detect(const cv::Mat &img, Detector &detector, double minimumScore) const;
+
+    // Gán nhãn cho nhiều ảnh: tile của nhiều ảnh được gom chung batch; mỗi ảnh là 1 item của progress.
+    // labelPaths: ảnh -> label đã ghép (vd. labels/<...> từ DatasetScanner); ảnh không có trong map
+    // hoặc map null -> .txt cạnh ảnh
+    int labelImages(const QStringList &imagePaths, Detector &detector, double minimumScore,
+                    ProgressChannel *progress = nullptr,
+                    const QHash<QString, QString> *labelPaths = nullptr) const;
+
+private:
+    Options m_options;
+};
+
+#endif // SLICEDINFERENCE_H
@@ -0,0 +1,61 @@
+#include "spatialgrid.h"
+#include <QSet>
+#include <algorithm>
+#include <cmath>
+
+SpatialGrid::SpatialGrid(int cellWidth, int cellHeight)
+    : m_cellWidth(std::max(1, cellWidth)), m_cellHeight(std::max(1, cellHeight))
+{ }
+
+quint64 SpatialGrid::cellKey(int cx, int cy)
+{
+    return (quint64(quint32(cx)) << 32) | quint32(cy);
+}
+
+int SpatialGrid::cellX(int x) const
+{
+    return int(std::floor(double(x) / m_cellWidth));
+}
+
+int SpatialGrid::cellY(int y) const
+{
+    return int(std::floor(double(y) / m_cellHeight));
+}
+
+void SpatialGrid::insert(int id, const cv::Rect &rect)
+{
+    m_rects.insert(id, rect);
+    int x1 = cellX(rect.x), x2 = cellX(rect.x + std::max(0, rect.width - 1));
+    int y1 = cellY(rect.y), y2 = cellY(rect.y + std::max(0, rect.height - 1));
+    for (int cy = y1; cy <= y2; ++cy)
+        for (int cx = x1; cx <= x2; ++cx)
+            m_cells[cellKey(cx, cy)].push_back(id);
+}
+
+void SpatialGrid::clear()
+{
+    m_cells.clear();
+    m_rects.clear();
+}
+
+QVector<int> SpatialGrid::query(const cv::Rect &rect) const
+{
+    QVector<int> result;
+    QSet<int> seen;
+    int x1 = cellX(rect.x), x2 = cellX(rect.x + std::max(0, rect.width - 1));
+    int y1 = cellY(rect.y), y2 = cellY(rect.y + std::max(0, rect.height - 1));
+    for (int cy = y1; cy <= y2; ++cy) {
+        for (int cx = x1; cx <= x2; ++cx) {
+            auto it = m_cells.constFind(cellKey(cx, cy));
+            if (it == m_cells.constEnd()) continue;
+            for (int id : *it) {
+                if (!seen.contains(id)) {
+                    seen.insert(id);
+                    result.push_back(id);
+                }
+            }
+        }
+    }
+    std::sort(result.begin(), result.end()); // thứ tự ổn định, không phụ thuộc hash
+    return result;
+}
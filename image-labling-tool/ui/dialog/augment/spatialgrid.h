@@ -0,0 +1,33 @@
+#ifndef SPATIALGRID_H
+#define SPATIALGRID_H
+
+#include <opencv2/core.hpp>
+#include <QHash>
+#include <QVector>
+
+// Lưới đều để tìm nhanh các rect có thể giao nhau (thay cho duyệt toàn bộ)
+class SpatialGrid
+{
+public:
+    explicit SpatialGrid(int cellWidth = 256, int cellHeight = 256);
+
+    void insert(int id, const cv::Rect &rect);
+    void clear();
+
+    // id các rect nằm trong những ô mà `rect` chạm vào (có thể chưa thực sự giao, không trùng lặp)
+    QVector<int> query(const cv::Rect &rect) const;
+
+    const cv::Rect &rect(int id) const { return m_rects[id]; }
+
+private:
+    static quint64 cellKey(int cx, int cy);
+    int cellX(int x) const;
+    int cellY(int y) const;
+
+    int m_cellWidth;
+    int m_cellHeight;
+    QHash<quint64, QVector<int>> m_cells;
+    QHash<int, cv::Rect> m_rects;
+};
+
+#endif // SPATIALGRID_H
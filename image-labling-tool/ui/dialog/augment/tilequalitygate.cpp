@@ -0,0 +1,146 @@
+#include "tilequalitygate.h"
+#include "imagehash.h"
+#include <QRegularExpression>
+#include <QStringList>
+#include <numeric>
+
+QString TileQualityGate::reasonName(Reason reason)
+{
+    switch (reason) {
+    case Accepted:  return "accepted";
+    case Sliver:    return "sliver";
+    case Uniform:   return "uniform";
+    case Blurry:    return "blurry";
+    case Duplicate: return "duplicate";
+    }
+    return QString();
+}
+
+bool TileQualityGate::Options::pixelChecks() const
+{
+    return minStdDev > 0.0 || maxUniformFraction < 1.0 || minLaplacianVariance > 0.0 || maxHashDistance >= 0;
+}
+
+QString TileQualityGate::suggestedSpec()
+{
+    return "visible=0.25 std=2 uniform=0.95 dup=3";
+}
+
+bool TileQualityGate::parse(const QString &spec, Options *options, QString *error)
+{
+    static const QRegularExpression rx("^(\\w+)\\s*[=:]\\s*([0-9]*\\.?[0-9]+)$");
+
+    Options o;
+    for (const QString &part : spec.split(QRegularExpression("[\\s,;]+"), Qt::SkipEmptyParts)) {
+        QRegularExpressionMatch m = rx.match(part);
+        if (!m.hasMatch()) {
+            if (error) *error = QString("Cannot parse tile gate '%1' (expected key=value)").arg(part);
+            return false;
+        }
+        QString key = m.captured(1).toLower();
+        double value = m.captured(2).toDouble();
+
+        if (key == "visible") o.minVisibleFraction = value;
+        else if (key == "std") o.minStdDev = value;
+        else if (key == "uniform") o.maxUniformFraction = value;
+        else if (key == "blur") o.minLaplacianVariance = value;
+        else if (key == "dup") o.maxHashDistance = int(value);
+        else {
+            if (error) *error = QString("Unknown tile gate key: %1 (visible, std, uniform, blur, dup)").arg(m.captured(1));
+            return false;
+        }
+    }
+
+    if (o.minVisibleFraction > 1.0 || o.maxUniformFraction > 1.0 || o.maxHashDistance > 64) {
+        if (error) *error = "visible and uniform must be in [0, 1], dup in [0, 64]";
+        return false;
+    }
+    *options = o;
+    return true;
+}
+
+void TileQualityGate::Stats::merge(const Stats &other)
+{
+    for (int i = 0; i < ReasonCount; ++i)
+        count[i] += other.count[i];
+    droppedBoxes += other.droppedBoxes;
+}
+
+int TileQualityGate::Stats::rejected() const
+{
+    return std::accumulate(count.begin() + 1, count.end(), 0);
+}
+
+QString TileQualityGate::Stats::summary() const
+{
+    QStringList reasons;
+    for (int i = Sliver; i < ReasonCount; ++i)
+        reasons << QString("%1 %2").arg(reasonName(Reason(i))).arg(count[i]);
+    return QString("tile gate: %1 written, %2 rejected (%3), %4 boxes dropped")
+        .arg(count[Accepted])
+        .arg(rejected())
+        .arg(reasons.join(", "))
+        .arg(droppedBoxes);
+}
+
+TileQualityGate::Measure TileQualityGate::measure(const cv::Mat &tile) const
+{
+    Measure m;
+    if (tile.empty()) return m;
+
+    cv::Mat gray = ImageHash::toGray(tile);
+
+    if (m_options.minStdDev > 0.0) {
+        cv::Scalar mean, stddev;
+        cv::meanStdDev(gray, mean, stddev);
+        m.stdDev = stddev[0];
+    }
+
+    if (m_options.maxUniformFraction < 1.0) {
+        // mức xám phổ biến nhất chiếm bao nhiêu phần tile (padding đen/trắng, nền trơn)
+        cv::Mat hist;
+        int histSize = 256;
+        float range[] = {0, 256};
+        const float *ranges[] = {range};
+        int channel = 0;
+        cv::calcHist(&gray, 1, &channel, cv::Mat(), hist, 1, &histSize, ranges);
+        double maxCount = 0;
+        cv::minMaxLoc(hist, nullptr, &maxCount);
+        m.uniformFraction = maxCount / double(gray.total());
+    }
+
+    if (m_options.minLaplacianVariance > 0.0) {
+        // ảnh mờ ít cạnh -> đáp ứng Laplacian có phương sai nhỏ
+        cv::Mat lap;
+        cv::Laplacian(gray, lap, CV_16S);
+        cv::Scalar mean, stddev;
+        cv::meanStdDev(lap, mean, stddev);
+        m.laplacianVariance = stddev[0] * stddev[0];
+    }
+
+    if (m_options.maxHashDistance >= 0)
+        m.hash = ImageHash::dHash(gray);
+    return m;
+}
+
+TileQualityGate::Reason TileQualityGate::check(const Measure &measure) const
+{
+    // tile phẳng cũng không có cạnh -> xét Uniform trước để không bị tính là Blurry
+    if (m_options.minStdDev > 0.0 && measure.stdDev < m_options.minStdDev)
+        return Uniform;
+    if (m_options.maxUniformFraction < 1.0 && measure.uniformFraction > m_options.maxUniformFraction)
+        return Uniform;
+    if (m_options.minLaplacianVariance > 0.0 && measure.laplacianVariance < m_options.minLaplacianVariance)
+        return Blurry;
+    return Accepted;
+}
+
+bool TileQualityGate::isDuplicate(quint64 hash, const QVector<quint64> &accepted) const
+{
+    if (m_options.maxHashDistance < 0) return false;
+    for (quint64 other : accepted) {
+        if (ImageHash::distance(hash, other) <= m_options.maxHashDistance)
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,65 @@
+#ifndef TILEQUALITYGATE_H
+#define TILEQUALITYGATE_H
+
+#include <opencv2/opencv.hpp>
+#include <QString>
+#include <QVector>
+#include <array>
+
+// Cổng chất lượng cho tile, xét trước khi encode: bỏ tile chỉ còn mẩu box, tile phẳng/đơn sắc (padding),
+// tile mờ, và tile gần trùng 1 tile đã nhận của cùng ảnh nguồn (dHash)
+class TileQualityGate
+{
+public:
+    enum Reason { Accepted, Sliver, Uniform, Blurry, Duplicate };
+    static constexpr int ReasonCount = 5;
+    static QString reasonName(Reason reason);
+
+    struct Options {
+        double minVisibleFraction {0.0};   // box còn thấy < ngưỡng (theo diện tích) bị bỏ khỏi label; tile hết box -> Sliver
+        double minStdDev {0.0};            // độ lệch chuẩn độ sáng thấp hơn -> Uniform
+        double maxUniformFraction {1.0};   // tỉ lệ pixel cùng mức xám phổ biến nhất cao hơn -> Uniform (padding, nền trơn)
+        double minLaplacianVariance {0.0}; // phương sai Laplacian thấp hơn -> Blurry
+        int maxHashDistance {-1};          // Hamming dHash <= ngưỡng với tile đã nhận -> Duplicate; < 0 -> tắt
+
+        bool pixelChecks() const;          // có điều kiện nào cần đọc pixel không
+    };
+
+    // "visible=0.25 std=2 uniform=0.95 blur=40 dup=3"; key nào không có thì tắt điều kiện đó
+    static bool parse(const QString &spec, Options *options, QString *error = nullptr);
+    // Ngưỡng gợi ý cho nút Suggested; mặc định gate tắt để Tile giữ nguyên output cũ
+    static QString suggestedSpec();
+
+    struct Measure {
+        double stdDev {0.0};
+        double uniformFraction {0.0};
+        double laplacianVariance {0.0};
+        quint64 hash {0};
+    };
+
+    struct Stats {
+        std::array<int, ReasonCount> count {}; // count[Accepted]: số tile được ghi
+        int droppedBoxes {0};                  // box bị bỏ khỏi label vì còn thấy quá ít
+
+        void add(Reason reason) { count[reason]++; }
+        void merge(const Stats &other);
+        int rejected() const;
+        QString summary() const;
+    };
+
+    TileQualityGate() = default;
+    explicit TileQualityGate(const Options &options) : m_options(options) { }
+
+    const Options &options() const { return m_options; }
+
+    // Chỉ đo các đại lượng đang bật, trên ảnh xám bằng hàm OpenCV đã vector hoá (meanStdDev, calcHist, Laplacian)
+    Measure measure(const cv::Mat &tile) const;
+    // Uniform / Blurry / Accepted; trùng được xét riêng vì phụ thuộc thứ tự tile
+    Reason check(const Measure &measure) const;
+    bool isDuplicate(quint64 hash, const QVector<quint64> &accepted) const;
+
+private:
+    Options m_options;
+};
+
+#endif // TILEQUALITYGATE_H
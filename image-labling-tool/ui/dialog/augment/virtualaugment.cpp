@@ -0,0 +1,351 @@
+#include "virtualaugment.h"
+#include "imagetiler.h"
+#include <QtConcurrent/QtConcurrent>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QDebug>
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+const char *kManifestKind = "virtual-augment";
+const int kManifestVersion = 1;
+
+}
+
+QString AugmentManifest::defaultPath(const QString &dir)
+{
+    return QDir(dir).filePath("augment_manifest.jsonl");
+}
+
+QString AugmentManifest::sampleName(const QString &manifestDir, const QString &imagePath,
+                                    const QString &outputBaseName)
+{
+    if (manifestDir.isEmpty()) return outputBaseName;
+    QString rel = QDir(manifestDir).relativeFilePath(QFileInfo(imagePath).absolutePath()); // luôn dùng '/'
+    return rel.isEmpty() || rel == "." ? outputBaseName : rel + "/" + outputBaseName;
+}
+
+QByteArray AugmentManifest::encode(const VirtualSample &sample, const QDir &base)
+{
+    QJsonObject obj;
+    obj["name"] = sample.name;
+    obj["src"] = base.relativeFilePath(sample.sourcePath);
+    if (sample.scale != 1.0)
+        obj["scale"] = sample.scale;
+    if (!sample.crop.empty())
+        obj["crop"] = QJsonArray{sample.crop.x, sample.crop.y, sample.crop.width, sample.crop.height};
+
+    QJsonArray ops;
+    for (const auto &step : sample.steps) {
+        QJsonObject op;
+        op["op"] = AugmentPolicy::opName(step.op);
+        if (step.magnitude != 0.0)
+            op["m"] = step.magnitude;
+        if (step.op == AugmentOp::Noise) // seed 64 bit, JSON number chỉ giữ được 53 bit
+            op["seed"] = QString::number(step.seed, 16);
+        ops.append(op);
+    }
+    if (!ops.isEmpty())
+        obj["ops"] = ops;
+
+    QJsonArray labels;
+    for (const auto &b : sample.boxes)
+        labels.append(QJsonArray{b.cls, double(b.xc), double(b.yc), double(b.w), double(b.h)});
+    obj["labels"] = labels;
+
+    return QJsonDocument(obj).toJson(QJsonDocument::Compact);
+}
+
+bool AugmentManifest::decode(const QByteArray &line, const QDir &base, VirtualSample *sample, QString *error)
+{
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(line, &parseError);
+    if (!doc.isObject()) {
+        if (error) *error = parseError.errorString();
+        return false;
+    }
+    QJsonObject obj = doc.object();
+
+    VirtualSample s;
+    s.name = obj["name"].toString();
+    s.sourcePath = QDir::cleanPath(base.absoluteFilePath(obj["src"].toString()));
+    if (s.name.isEmpty() || obj["src"].toString().isEmpty()) {
+        if (error) *error = "missing name or src";
+        return false;
+    }
+
+    s.scale = obj["scale"].toDouble(1.0);
+    QJsonArray crop = obj["crop"].toArray();
+    if (crop.size() == 4)
+        s.crop = cv::Rect(crop[0].toInt(), crop[1].toInt(), crop[2].toInt(), crop[3].toInt());
+
+    for (const auto &v : obj["ops"].toArray()) {
+        QJsonObject op = v.toObject();
+        TransformStep step {AugmentOp::FlipHorizontal};
+        if (!AugmentPolicy::opFromName(op["op"].toString(), &step.op)) {
+            if (error) *error = QString("unknown op '%1'").arg(op["op"].toString());
+            return false;
+        }
+        step.magnitude = op["m"].toDouble();
+        step.seed = op["seed"].toString().toULongLong(nullptr, 16);
+        s.steps.push_back(step);
+    }
+
+    for (const auto &v : obj["labels"].toArray()) {
+        QJsonArray b = v.toArray();
+        if (b.size() != 5) continue;
+        s.boxes.push_back({b[0].toInt(), float(b[1].toDouble()), float(b[2].toDouble()),
+                           float(b[3].toDouble()), float(b[4].toDouble())});
+    }
+
+    *sample = s;
+    return true;
+}
+
+bool AugmentManifest::read(const QString &path, QVector<VirtualSample> *samples, QString *error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) *error = QString("Cannot open manifest: %1").arg(path);
+        return false;
+    }
+
+    QDir base = QFileInfo(path).absoluteDir();
+    samples->clear();
+    int lineNo = 0;
+    while (!file.atEnd()) {
+        QByteArray line = file.readLine().trimmed();
+        lineNo++;
+        if (line.isEmpty()) continue;
+
+        if (lineNo == 1) {
+            QJsonObject header = QJsonDocument::fromJson(line).object();
+            if (header["manifest"].toString() != kManifestKind) {
+                if (error) *error = QString("%1 is not an augmentation manifest").arg(path);
+                return false;
+            }
+            if (header["version"].toInt() > kManifestVersion) {
+                if (error) *error = QString("Unsupported manifest version %1").arg(header["version"].toInt());
+                return false;
+            }
+            continue;
+        }
+
+        VirtualSample s;
+        QString lineError;
+        if (!decode(line, base, &s, &lineError)) {
+            if (error) *error = QString("%1:%2: %3").arg(path).arg(lineNo).arg(lineError);
+            return false;
+        }
+        samples->push_back(s);
+    }
+    return true;
+}
+
+bool AugmentManifest::write(const QString &path, const QVector<VirtualSample> &samples, QString *error)
+{
+    // ghi ra file tạm rồi rename -> reader không bao giờ thấy manifest ghi dở
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (error) *error = QString("Cannot write manifest: %1").arg(path);
+        return false;
+    }
+
+    QDir base = QFileInfo(path).absoluteDir();
+    QJsonObject header;
+    header["manifest"] = kManifestKind;
+    header["version"] = kManifestVersion;
+    header["samples"] = samples.size();
+    file.write(QJsonDocument(header).toJson(QJsonDocument::Compact));
+    file.write("\n");
+
+    for (const auto &s : samples) {
+        file.write(encode(s, base));
+        file.write("\n");
+    }
+
+    if (!file.commit()) {
+        if (error) *error = QString("Cannot write manifest: %1").arg(path);
+        return false;
+    }
+    return true;
+}
+
+bool AugmentManifest::merge(const QString &path, const QVector<VirtualSample> &samples, QString *error)
+{
+    QVector<VirtualSample> all;
+    if (QFile::exists(path) && !read(path, &all, error))
+        return false;
+
+    QHash<QString, int> byName;
+    for (int i = 0; i < all.size(); ++i)
+        byName.insert(all[i].name, i);
+
+    for (const auto &s : samples) {
+        auto it = byName.constFind(s.name);
+        if (it != byName.constEnd()) {
+            all[*it] = s;
+        } else {
+            byName.insert(s.name, all.size());
+            all.push_back(s);
+        }
+    }
+    return write(path, all, error);
+}
+
+cv::Mat AugmentManifest::render(const cv::Mat &source, const VirtualSample &sample)
+{
+    if (source.empty()) return cv::Mat();
+
+    cv::Mat scaled = source;
+    if (sample.scale != 1.0) {
+        // cùng kích thước/nội suy như pyramid của ImageTiler::process()
+        QSize size = ImageTiler::levelSize(source.cols, source.rows, sample.scale);
+        cv::resize(source, scaled, cv::Size(size.width(), size.height()), 0, 0, cv::INTER_AREA);
+    }
+
+    cv::Mat img;
+    if (sample.crop.empty()) {
+        img = sample.scale != 1.0 ? scaled : scaled.clone();
+    } else {
+        cv::Rect roi = sample.crop & cv::Rect(0, 0, scaled.cols, scaled.rows);
+        if (roi.empty()) return cv::Mat();
+        img = scaled(roi).clone();
+    }
+
+    for (const auto &step : sample.steps)
+        AugmentPolicy::transformImage(step, img);
+    return img;
+}
+
+VirtualDatasetReader::VirtualDatasetReader() = default;
+
+VirtualDatasetReader::~VirtualDatasetReader()
+{
+    stop();
+}
+
+bool VirtualDatasetReader::open(const QString &manifestPath, QString *error)
+{
+    stop();
+    QVector<VirtualSample> samples;
+    if (!AugmentManifest::read(manifestPath, &samples, error))
+        return false;
+    setSamples(samples);
+    return true;
+}
+
+void VirtualDatasetReader::setSamples(const QVector<VirtualSample> &samples)
+{
+    stop();
+    m_samples = samples;
+}
+
+void VirtualDatasetReader::setMaxThreads(int n)
+{
+    m_pool.setMaxThreadCount(n > 0 ? n : QThread::idealThreadCount());
+}
+
+void VirtualDatasetReader::setPrefetch(int depth)
+{
+    m_prefetch = std::max(1, depth);
+}
+
+cv::Mat VirtualDatasetReader::source(const QString &path)
+{
+    std::shared_future<cv::Mat> future;
+    std::promise<cv::Mat> promise;
+    bool owner = false;
+    {
+        QMutexLocker lock(&m_cacheMutex);
+        auto it = m_cache.constFind(path);
+        if (it != m_cache.constEnd()) {
+            future = *it;
+        } else {
+            future = promise.get_future().share();
+            m_cache.insert(path, future);
+            m_cacheOrder.push_back(path);
+            owner = true;
+
+            // giữ tối đa khoảng số sample đang chuẩn bị; ảnh đang được dùng vẫn sống nhờ shared_future
+            size_t capacity = size_t(std::max(4, m_prefetch));
+            while (m_cacheOrder.size() > capacity) {
+                m_cache.remove(m_cacheOrder.front());
+                m_cacheOrder.pop_front();
+            }
+        }
+    }
+
+    if (owner) {
+        cv::Mat img = cv::imread(path.toStdString());
+        if (img.empty())
+            qWarning() << "VirtualDatasetReader: cannot read" << path;
+        promise.set_value(img);
+    }
+    return future.get();
+}
+
+VirtualDatasetReader::Sample VirtualDatasetReader::read(int index)
+{
+    Sample out;
+    out.index = index;
+    if (index < 0 || index >= m_samples.size()) return out;
+
+    const VirtualSample &s = m_samples[index];
+    out.name = s.name;
+    out.boxes = s.boxes;
+    out.image = AugmentManifest::render(source(s.sourcePath), s);
+    out.ok = !out.image.empty();
+    return out;
+}
+
+void VirtualDatasetReader::start(const QVector<int> &order)
+{
+    stop();
+    if (order.isEmpty()) {
+        m_order.resize(m_samples.size());
+        std::iota(m_order.begin(), m_order.end(), 0);
+    } else {
+        m_order = order;
+    }
+    m_scheduled = 0;
+    schedule();
+}
+
+void VirtualDatasetReader::schedule()
+{
+    while (int(m_inFlight.size()) < m_prefetch && m_scheduled < m_order.size()) {
+        int index = m_order[m_scheduled++];
+        m_inFlight.push_back(QtConcurrent::run(&m_pool, [this, index]() { return read(index); }));
+    }
+}
+
+bool VirtualDatasetReader::next(Sample *out)
+{
+    if (m_inFlight.empty()) return false;
+
+    QFuture<Sample> front = m_inFlight.front();
+    m_inFlight.pop_front();
+    schedule(); // giữ hàng đợi đầy trong lúc chờ sample đầu
+    *out = front.result();
+    return true;
+}
+
+void VirtualDatasetReader::stop()
+{
+    for (auto &f : m_inFlight)
+        f.waitForFinished();
+    m_inFlight.clear();
+    m_order.clear();
+    m_scheduled = 0;
+
+    QMutexLocker lock(&m_cacheMutex);
+    m_cache.clear();
+    m_cacheOrder.clear();
+}
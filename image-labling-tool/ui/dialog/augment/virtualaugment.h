@@ -0,0 +1,99 @@
+#ifndef VIRTUALAUGMENT_H
+#define VIRTUALAUGMENT_H
+
+#include <opencv2/opencv.hpp>
+#include <QByteArray>
+#include <QDir>
+#include <QFuture>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QThreadPool>
+#include <QVector>
+#include <deque>
+#include <future>
+#include "augmentpolicy.h"
+#include "yololabel.h"
+
+// Một sample ảo: ảnh nguồn + chuỗi transform + label đã biến đổi; ảnh chỉ được tạo khi đọc
+struct VirtualSample {
+    QString name;        // tên như khi ghi ra file thật, kèm thư mục con so với manifest: img_FH, train/img_A3
+    QString sourcePath;  // tuyệt đối (trong manifest lưu tương đối theo thư mục manifest)
+    double scale {1.0};  // thu nhỏ ảnh nguồn (INTER_AREA) trước khi cắt, cho tile ở các mức pyramid
+    cv::Rect crop;       // rỗng -> cả ảnh; toạ độ theo ảnh đã thu nhỏ; cắt trước rồi mới áp steps
+    QVector<TransformStep> steps;
+    QVector<BBox> boxes;
+};
+
+// Manifest dạng JSON Lines: dòng đầu là header, mỗi dòng sau là 1 sample
+class AugmentManifest
+{
+public:
+    static QString defaultPath(const QString &dir);
+    // Tên sample: thư mục của ảnh tương đối theo thư mục manifest + tên file ra (không đuôi),
+    // nên train/a.jpg và val/a.jpg không đè nhau khi merge; manifestDir rỗng -> chỉ tên file
+    static QString sampleName(const QString &manifestDir, const QString &imagePath, const QString &outputBaseName);
+
+    static bool read(const QString &path, QVector<VirtualSample> *samples, QString *error = nullptr);
+    static bool write(const QString &path, const QVector<VirtualSample> &samples, QString *error = nullptr);
+    // Sample trùng tên thay sample cũ (chạy lại cùng op không nhân đôi manifest)
+    static bool merge(const QString &path, const QVector<VirtualSample> &samples, QString *error = nullptr);
+
+    static QByteArray encode(const VirtualSample &sample, const QDir &base);
+    static bool decode(const QByteArray &line, const QDir &base, VirtualSample *sample, QString *error = nullptr);
+
+    // Ảnh nguồn đã decode -> ảnh của sample; dùng chung transform với đường ghi file thật
+    static cv::Mat render(const cv::Mat &source, const VirtualSample &sample);
+};
+
+// Đọc sample ảo cho training loader: decode + transform trên worker pool, chuẩn bị trước `prefetch` sample
+class VirtualDatasetReader
+{
+public:
+    struct Sample {
+        int index {-1};
+        QString name;
+        cv::Mat image;
+        QVector<BBox> boxes;
+        bool ok {false};
+    };
+
+    VirtualDatasetReader();
+    ~VirtualDatasetReader();
+
+    bool open(const QString &manifestPath, QString *error = nullptr);
+    void setSamples(const QVector<VirtualSample> &samples);
+
+    int size() const { return m_samples.size(); }
+    const VirtualSample &sample(int index) const { return m_samples[index]; }
+
+    void setMaxThreads(int n); // <= 0 -> theo số core
+    void setPrefetch(int depth);
+
+    // Đọc đồng bộ 1 sample
+    Sample read(int index);
+
+    // Đọc tuần tự theo order (rỗng -> 0..size-1); trả về đúng thứ tự dù worker xong lệch nhau
+    void start(const QVector<int> &order = QVector<int>());
+    bool next(Sample *out);
+    void stop();
+
+private:
+    cv::Mat source(const QString &path);
+    void schedule();
+
+    QVector<VirtualSample> m_samples;
+    QThreadPool m_pool;
+    int m_prefetch {16};
+
+    QVector<int> m_order;
+    int m_scheduled {0};
+    std::deque<QFuture<Sample>> m_inFlight;
+
+    // cache ảnh nguồn đã decode: các variant liền nhau của cùng ảnh chỉ decode 1 lần
+    QMutex m_cacheMutex;
+    QHash<QString, std::shared_future<cv::Mat>> m_cache;
+    std::deque<QString> m_cacheOrder;
+};
+
+#endif // VIRTUALAUGMENT_H
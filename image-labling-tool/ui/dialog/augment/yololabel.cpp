@@ -0,0 +1,81 @@
+#include "yololabel.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QTextStream>
+
+namespace YoloLabel {
+
+QString labelPathFor(const QString &imagePath)
+{
+    QFileInfo info(imagePath);
+    return info.absolutePath() + "/" + info.completeBaseName() + ".txt";
+}
+
+QString mirroredLabelDir(const QString &dir)
+{
+    QString path = dir + "/";
+    int i = path.lastIndexOf("/images/");
+    if (i < 0) return QString();
+    path.replace(i, 8, "/labels/");
+    path.chop(1);
+    return path;
+}
+
+QString outputLabelPathFor(const QString &outputBase, const QString &sourceImagePath,
+                           const QString &sourceLabelPath)
+{
+    QFileInfo out(outputBase);
+    if (!sourceLabelPath.isEmpty()
+        && QFileInfo(sourceLabelPath).absolutePath() != QFileInfo(sourceImagePath).absolutePath()) {
+        QString labelDir = mirroredLabelDir(out.absolutePath());
+        if (!labelDir.isEmpty())
+            return labelDir + "/" + out.fileName() + ".txt";
+    }
+    return outputBase + ".txt";
+}
+
+QVector<BBox> read(const QString &labelPath, bool *ok)
+{
+    QVector<BBox> boxes;
+    QFile file(labelPath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        if (ok) *ok = false;
+        return boxes;
+    }
+
+    QTextStream in(&file);
+    while (!in.atEnd()) {
+        QString line = in.readLine().trimmed();
+        if (line.isEmpty()) continue;
+
+        BBox b;
+        QTextStream ls(&line, QIODevice::ReadOnly);
+        ls >> b.cls >> b.xc >> b.yc >> b.w >> b.h;
+        if (ls.status() != QTextStream::Ok) continue;
+
+        boxes.push_back(b);
+    }
+
+    if (ok) *ok = true;
+    return boxes;
+}
+
+bool write(const QString &labelPath, const QVector<BBox> &boxes)
+{
+    QDir().mkpath(QFileInfo(labelPath).absolutePath()); // labels/<...> của thư mục ra có thể chưa có
+    QSaveFile file(labelPath); // tạm + rename, như EncoderProfile::write
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+
+    QTextStream out(&file);
+    for (const auto &b : boxes) {
+        out << b.cls << " " << b.xc << " " << b.yc << " "
+            << b.w << " " << b.h << "\n";
+    }
+    out.flush();
+    return file.commit();
+}
+
+}
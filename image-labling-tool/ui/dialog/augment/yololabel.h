@@ -0,0 +1,33 @@
+#ifndef YOLOLABEL_H
+#define YOLOLABEL_H
+
+#include <QString>
+#include <QVector>
+
+struct BBox {
+    int cls;
+    float xc, yc, w, h; // YOLO normalized
+};
+
+namespace YoloLabel {
+
+// Đường dẫn file label cạnh ảnh: <folder>/<baseName>.txt
+QString labelPathFor(const QString &imagePath);
+
+// ".../images/<...>" -> ".../labels/<...>" (lần xuất hiện cuối); không có images/ -> rỗng
+QString mirroredLabelDir(const QString &dir);
+
+// Label cho ảnh ghi ra (tile / augment), outputBase là đường dẫn ảnh ra không có đuôi.
+// Label nguồn nằm ở labels/<...> (không cạnh ảnh nguồn) và ảnh ra nằm dưới images/ -> labels/<...>/<tên>.txt,
+// để lần quét sau vẫn thấy 1 layout; còn lại -> cạnh ảnh ra
+QString outputLabelPathFor(const QString &outputBase, const QString &sourceImagePath,
+                           const QString &sourceLabelPath);
+
+// Đọc file label YOLO, bỏ qua các dòng lỗi
+QVector<BBox> read(const QString &labelPath, bool *ok = nullptr);
+
+bool write(const QString &labelPath, const QVector<BBox> &boxes);
+
+}
+
+#endif // YOLOLABEL_H